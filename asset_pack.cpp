@@ -0,0 +1,199 @@
+#include "asset_pack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "OS not supported yet"
+#endif
+
+namespace {
+  uint64_t align_up(uint64_t value, uint64_t alignment)
+  {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  bool is_power_of_two(uint64_t value)
+  {
+    return value != 0 && (value & (value - 1)) == 0;
+  }
+}
+
+AssetPack::AssetPack(const std::filesystem::path& path)
+{
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw std::runtime_error("failed to open asset pack \"" + path.string() + "\"!");
+  }
+
+  struct stat file_status;
+  if (fstat(fd, &file_status) == -1) {
+    close(fd);
+    throw std::runtime_error("failed to stat asset pack \"" + path.string() + "\"!");
+  }
+
+  mapping_size = static_cast<std::size_t>(file_status.st_size);
+  if (mapping_size < sizeof(asset_pack::Header)) {
+    close(fd);
+    throw std::runtime_error("asset pack \"" + path.string() + "\" is truncated!");
+  }
+
+  // the mapping keeps the file referenced after closing the descriptor
+  mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw std::runtime_error("failed to map asset pack \"" + path.string() + "\"!");
+  }
+
+  const auto* base = static_cast<const char*>(mapping);
+  asset_pack::Header header;
+  std::memcpy(&header, base, sizeof(header));
+
+  const auto fits = [this](uint64_t offset, uint64_t size) {
+    return offset <= mapping_size && size <= mapping_size - offset;
+  };
+
+  try {
+    if (std::memcmp(header.magic, asset_pack::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != asset_pack::VERSION) {
+      throw std::runtime_error("\"" + path.string() + "\" is not a supported asset pack!");
+    }
+
+    if (header.index_offset % alignof(asset_pack::IndexEntry) != 0 ||
+        !fits(header.index_offset, uint64_t{header.entry_count} * sizeof(asset_pack::IndexEntry)) ||
+        !fits(header.names_offset, header.names_size)) {
+      throw std::runtime_error("asset pack \"" + path.string() + "\" has a corrupt index!");
+    }
+
+    entries = reinterpret_cast<const asset_pack::IndexEntry*>(base + header.index_offset);
+    entry_count = header.entry_count;
+    names = base + header.names_offset;
+
+    // only the index is touched here, the blobs stay unread
+    for (std::size_t i = 0; i < entry_count; ++i) {
+      const auto& entry = entries[i];
+      if (!fits(entry.offset, entry.size) ||
+          entry.name_offset > header.names_size || entry.name_size > header.names_size - entry.name_offset ||
+          !is_power_of_two(entry.alignment) || entry.offset % entry.alignment != 0 ||
+          (i > 0 && !(name(i - 1) < name(i)))) {
+        throw std::runtime_error("asset pack \"" + path.string() + "\" has a corrupt index!");
+      }
+    }
+  } catch (...) {
+    munmap(mapping, mapping_size);
+    throw;
+  }
+}
+
+AssetPack::~AssetPack()
+{
+  munmap(mapping, mapping_size);
+}
+
+std::optional<AssetView> AssetPack::find(std::string_view asset_name) const
+{
+  const auto* end = entries + entry_count;
+  const auto* entry = std::lower_bound(entries, end, asset_name,
+                                       [this](const asset_pack::IndexEntry& e, std::string_view n) {
+                                         return std::string_view{names + e.name_offset, e.name_size} < n;
+                                       });
+  if (entry == end || std::string_view{names + entry->name_offset, entry->name_size} != asset_name)
+    return std::nullopt;
+
+  return AssetView{static_cast<const std::byte*>(mapping) + entry->offset, static_cast<std::size_t>(entry->size)};
+}
+
+std::size_t AssetPack::size() const
+{
+  return entry_count;
+}
+
+std::string_view AssetPack::name(std::size_t index) const
+{
+  const auto& entry = entries[index];
+  return {names + entry.name_offset, entry.name_size};
+}
+
+void AssetPackWriter::add(std::string name, std::vector<std::byte> data, uint32_t alignment)
+{
+  if (!is_power_of_two(alignment)) {
+    throw std::invalid_argument("asset alignment must be a power of two!");
+  }
+
+  assets.push_back({std::move(name), std::move(data), alignment});
+}
+
+void AssetPackWriter::write(const std::filesystem::path& path) const
+{
+  std::vector<const Asset*> sorted;
+  sorted.reserve(assets.size());
+  for (const auto& asset : assets)
+    sorted.push_back(&asset);
+  std::sort(sorted.begin(), sorted.end(), [](const Asset* a, const Asset* b) { return a->name < b->name; });
+
+  for (std::size_t i = 1; i < sorted.size(); ++i) {
+    if (sorted[i - 1]->name == sorted[i]->name) {
+      throw std::invalid_argument("duplicate asset \"" + sorted[i]->name + "\"!");
+    }
+  }
+
+  asset_pack::Header header{};
+  std::memcpy(header.magic, asset_pack::MAGIC, sizeof(header.magic));
+  header.version = asset_pack::VERSION;
+  header.entry_count = static_cast<uint32_t>(sorted.size());
+  header.index_offset = align_up(sizeof(header), alignof(asset_pack::IndexEntry));
+  header.names_offset = header.index_offset + sorted.size() * sizeof(asset_pack::IndexEntry);
+
+  std::vector<asset_pack::IndexEntry> index(sorted.size());
+  std::string names;
+  for (std::size_t i = 0; i < sorted.size(); ++i) {
+    index[i].name_offset = names.size();
+    index[i].name_size = static_cast<uint32_t>(sorted[i]->name.size());
+    index[i].alignment = sorted[i]->alignment;
+    index[i].size = sorted[i]->data.size();
+    names += sorted[i]->name;
+  }
+  header.names_size = names.size();
+
+  uint64_t offset = header.names_offset + header.names_size;
+  for (auto& entry : index) {
+    offset = align_up(offset, entry.alignment);
+    entry.offset = offset;
+    offset += entry.size;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to create asset pack \"" + path.string() + "\"!");
+  }
+
+  const auto write_at = [&file](uint64_t position, const void* data, std::size_t size) {
+    // pad up to the position of the next block
+    static const char zeros[4096] = {};
+    uint64_t current = static_cast<uint64_t>(file.tellp());
+    while (current < position) {
+      const auto padding = static_cast<std::size_t>(std::min<uint64_t>(position - current, sizeof(zeros)));
+      file.write(zeros, static_cast<std::streamsize>(padding));
+      current += padding;
+    }
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+  };
+
+  write_at(0, &header, sizeof(header));
+  write_at(header.index_offset, index.data(), index.size() * sizeof(asset_pack::IndexEntry));
+  write_at(header.names_offset, names.data(), names.size());
+  for (std::size_t i = 0; i < sorted.size(); ++i)
+    write_at(index[i].offset, sorted[i]->data.data(), sorted[i]->data.size());
+
+  if (!file) {
+    throw std::runtime_error("failed to write asset pack \"" + path.string() + "\"!");
+  }
+}
@@ -0,0 +1,102 @@
+#ifndef ASSET_PACK_HPP
+#define ASSET_PACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! Asset packs are laid out as a header, an index sorted by name, the
+//! names and the blobs, each blob aligned to the alignment requested
+//! for it. All integers are stored in host byte order.
+namespace asset_pack {
+  constexpr char MAGIC[8] = {'V', 'K', 'A', 'S', 'S', 'E', 'T', 'S'};
+  constexpr uint32_t VERSION = 1;
+
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t index_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+  };
+
+  struct IndexEntry
+  {
+    uint64_t name_offset;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t name_size;
+    uint32_t alignment;
+  };
+}
+
+//! read-only view of an asset inside a mapped pack
+class AssetView
+{
+public:
+  AssetView(const std::byte* data, std::size_t size) : data_begin{data}, data_size{size} {}
+
+  const std::byte* data() const { return data_begin; }
+  std::size_t size() const { return data_size; }
+  bool empty() const { return data_size == 0; }
+  const std::byte* begin() const { return data_begin; }
+  const std::byte* end() const { return data_begin + data_size; }
+
+private:
+  const std::byte* data_begin;
+  std::size_t data_size;
+};
+
+//! maps an asset pack into memory
+//!
+//! Opening only validates the header and the index, the blobs are paged
+//! in by the kernel when they are first touched. Views stay valid as
+//! long as the pack lives.
+class AssetPack
+{
+public:
+  explicit AssetPack(const std::filesystem::path& path);
+  AssetPack(const AssetPack&) = delete;
+  AssetPack& operator=(const AssetPack&) = delete;
+  ~AssetPack();
+
+  //! binary search over the sorted index
+  std::optional<AssetView> find(std::string_view name) const;
+
+  std::size_t size() const;
+  std::string_view name(std::size_t index) const;
+
+private:
+  void* mapping = nullptr;
+  std::size_t mapping_size = 0;
+  const asset_pack::IndexEntry* entries = nullptr;
+  std::size_t entry_count = 0;
+  const char* names = nullptr;
+};
+
+//! collects assets in memory and writes them as a pack
+class AssetPackWriter
+{
+public:
+  //! \p alignment has to be a power of two
+  void add(std::string name, std::vector<std::byte> data, uint32_t alignment = 16);
+  void write(const std::filesystem::path& path) const;
+
+private:
+  struct Asset
+  {
+    std::string name;
+    std::vector<std::byte> data;
+    uint32_t alignment;
+  };
+
+  std::vector<Asset> assets;
+};
+
+#endif // ASSET_PACK_HPP
@@ -0,0 +1,46 @@
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct DrawCommand {
+  uint vertexCount;
+  uint instanceCount;
+  uint firstVertex;
+  uint firstInstance;
+};
+
+// tightly packed Instance structs: offset x, offset y, scale, color
+layout(std430, binding = 0) readonly buffer Objects {
+  float objects[];
+};
+
+layout(std430, binding = 1) writeonly buffer DrawCommands {
+  DrawCommand commands[];
+};
+
+layout(std430, binding = 2) buffer DrawCount {
+  uint drawCount;
+};
+
+layout(push_constant) uniform Constants {
+  vec4 view;
+  uint objectCount;
+  uint vertexCount;
+};
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= objectCount) {
+    return;
+  }
+
+  vec2 offset = vec2(objects[6 * index], objects[6 * index + 1]);
+  float extent = 0.5 * objects[6 * index + 2];
+  if (offset.x + extent < view.x || offset.x - extent > view.z ||
+      offset.y + extent < view.y || offset.y - extent > view.w) {
+    return;
+  }
+
+  uint slot = atomicAdd(drawCount, 1);
+  commands[slot] = DrawCommand(vertexCount, 1, 0, index);
+}
@@ -0,0 +1,44 @@
+#include "embedded_shaders.hpp"
+
+#include <array>
+#include <utility>
+
+namespace {
+  // the .inc files are generated by glslc -mfmt=c and hold a braced
+  // list of SPIR-V words
+  alignas(4) constexpr uint32_t vert_spirv[] =
+#include "vert.spv.inc"
+    ;
+  alignas(4) constexpr uint32_t vert_instanced_spirv[] =
+#include "vert_instanced.spv.inc"
+    ;
+  alignas(4) constexpr uint32_t frag_spirv[] =
+#include "frag.spv.inc"
+    ;
+  alignas(4) constexpr uint32_t cull_spirv[] =
+#include "cull.spv.inc"
+    ;
+
+  template<std::size_t N>
+  constexpr std::pair<std::string_view, EmbeddedShader> entry(std::string_view name, const uint32_t (&code)[N])
+  {
+    return {name, {code, sizeof(code)}};
+  }
+
+  constexpr std::array shaders{
+    entry("vert.spv", vert_spirv),
+    entry("vert_instanced.spv", vert_instanced_spirv),
+    entry("frag.spv", frag_spirv),
+    entry("cull.spv", cull_spirv)
+  };
+}
+
+EmbeddedShader find_embedded_shader(std::string_view name)
+{
+  for (const auto& [shader_name, shader] : shaders) {
+    if (shader_name == name)
+      return shader;
+  }
+
+  return {nullptr, 0};
+}
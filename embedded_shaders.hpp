@@ -0,0 +1,20 @@
+#ifndef EMBEDDED_SHADERS_HPP
+#define EMBEDDED_SHADERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//! SPIR-V compiled into the executable by add_shader
+struct EmbeddedShader
+{
+  const uint32_t* code;
+  //! in bytes, as expected by VkShaderModuleCreateInfo::codeSize
+  std::size_t size;
+};
+
+//! looks a shader up by its .spv file name, code is nullptr if no
+//! shader of that name was embedded
+EmbeddedShader find_embedded_shader(std::string_view name);
+
+#endif // EMBEDDED_SHADERS_HPP
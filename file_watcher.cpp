@@ -0,0 +1,61 @@
+#include "file_watcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#error "OS not supported yet"
+#endif
+
+FileWatcher::FileWatcher(const std::filesystem::path& directory)
+{
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd == -1) {
+    throw std::runtime_error("failed to initialize inotify!");
+  }
+
+  if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+    close(fd);
+    throw std::runtime_error("failed to watch \"" + directory.string() + "\"!");
+  }
+}
+
+FileWatcher::~FileWatcher()
+{
+  // closing the descriptor removes the watch
+  close(fd);
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+  std::vector<std::string> names;
+
+  alignas(inotify_event) char buffer[4096];
+  for (;;) {
+    const ssize_t nbytes = read(fd, buffer, sizeof(buffer));
+    if (nbytes == -1) {
+      if (errno == EAGAIN)
+        break;
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("failed to read inotify events!");
+    }
+
+    for (ssize_t offset = 0; offset < nbytes;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      // len includes the padding of the name
+      if (event->len > 0) {
+        std::string name{event->name};
+        if (std::find(names.begin(), names.end(), name) == names.end())
+          names.push_back(std::move(name));
+      }
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+  }
+
+  return names;
+}
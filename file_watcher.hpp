@@ -0,0 +1,30 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+//! reports files of a directory which have been written
+//!
+//! The directory is watched instead of the files themselves, tools
+//! which replace a file by renaming a new one over it would otherwise
+//! end the watch. poll() never blocks, it is meant to be called once
+//! per frame.
+class FileWatcher
+{
+public:
+  explicit FileWatcher(const std::filesystem::path& directory);
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+  ~FileWatcher();
+
+  //! names of the files closed after writing or moved into the
+  //! directory since the last call, each name is reported once
+  std::vector<std::string> poll();
+
+private:
+  int fd = -1;
+};
+
+#endif // FILE_WATCHER_HPP
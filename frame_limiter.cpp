@@ -0,0 +1,41 @@
+#include "frame_limiter.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+FrameLimiter::FrameLimiter(double frames_per_second, Clock clock, double spin_time) :
+    clock{std::move(clock)},
+    frame_period{frames_per_second > 0.0 ? 1.0 / frames_per_second : 0.0},
+    spin_time{spin_time}
+{
+  if (frames_per_second <= 0.0) {
+    throw std::invalid_argument("frame rate must be positive!");
+  }
+}
+
+void FrameLimiter::wait()
+{
+  double now = clock();
+  if (!started) {
+    started = true;
+    next_frame = now + frame_period;
+    return;
+  }
+
+  if (next_frame - now > spin_time)
+    std::this_thread::sleep_for(std::chrono::duration<double>{next_frame - now - spin_time});
+
+  while ((now = clock()) < next_frame)
+    std::this_thread::yield();
+
+  next_frame += frame_period;
+  if (next_frame < now)
+    next_frame = now + frame_period;
+}
+
+double FrameLimiter::period() const
+{
+  return frame_period;
+}
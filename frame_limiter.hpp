@@ -0,0 +1,32 @@
+#ifndef FRAME_LIMITER_HPP
+#define FRAME_LIMITER_HPP
+
+#include <functional>
+
+//! paces frames to a fixed rate on the CPU
+//!
+//! wait() sleeps for most of the remaining time and spins for the last
+//! \p spin_time seconds, sleeping alone overshoots by the wakeup
+//! latency of the scheduler. A frame that is late does not shorten
+//! the following ones, the schedule restarts from now instead.
+class FrameLimiter
+{
+public:
+  //! returns seconds since an arbitrary epoch, e.g. GraphicsContext::time()
+  using Clock = std::function<double()>;
+
+  FrameLimiter(double frames_per_second, Clock clock, double spin_time = 0.002);
+
+  //! blocks until the next frame is due, the first call returns at once
+  void wait();
+  double period() const;
+
+private:
+  Clock clock;
+  double frame_period;
+  double spin_time;
+  double next_frame = 0.0;
+  bool started = false;
+};
+
+#endif // FRAME_LIMITER_HPP
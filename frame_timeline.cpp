@@ -0,0 +1,72 @@
+#include "frame_timeline.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+FrameTimeline::FrameTimeline(VkDevice device) :
+    device{device}
+{
+  VkSemaphoreTypeCreateInfo type_info{};
+  type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  type_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo create_info{};
+  create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  create_info.pNext = &type_info;
+
+  if (vkCreateSemaphore(device, &create_info, nullptr, &semaphore) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create timeline semaphore!");
+  }
+}
+
+FrameTimeline::~FrameTimeline()
+{
+  vkDestroySemaphore(device, semaphore, nullptr);
+}
+
+VkSemaphore FrameTimeline::get() const
+{
+  return semaphore;
+}
+
+uint64_t FrameTimeline::advance()
+{
+  return ++reserved_value;
+}
+
+uint64_t FrameTimeline::last_value() const
+{
+  return reserved_value;
+}
+
+uint64_t FrameTimeline::completed_value() const
+{
+  uint64_t completed;
+  if (vkGetSemaphoreCounterValue(device, semaphore, &completed) != VK_SUCCESS) {
+    throw std::runtime_error("failed to read timeline semaphore!");
+  }
+
+  return completed;
+}
+
+bool FrameTimeline::is_complete(uint64_t value) const
+{
+  return completed_value() >= value;
+}
+
+void FrameTimeline::wait(uint64_t value) const
+{
+  if (value == 0)
+    return;
+
+  VkSemaphoreWaitInfo wait_info{};
+  wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &semaphore;
+  wait_info.pValues = &value;
+
+  if (vkWaitSemaphores(device, &wait_info, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS) {
+    throw std::runtime_error("failed to wait for timeline semaphore!");
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef FRAME_TIMELINE_HPP
+#define FRAME_TIMELINE_HPP
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstdint>
+
+//! counts retired GPU work with a timeline semaphore
+//!
+//! Every submission signals the next value, so "has submission n
+//! finished" is a comparison against the counter instead of a fence
+//! per object. Resources tagged with the value of their last use can be
+//! recycled as soon as completed_value() reaches it.
+class FrameTimeline
+{
+public:
+  explicit FrameTimeline(VkDevice device);
+  FrameTimeline(const FrameTimeline&) = delete;
+  FrameTimeline& operator=(const FrameTimeline&) = delete;
+  ~FrameTimeline();
+
+  VkSemaphore get() const;
+
+  //! reserves the value the next submission has to signal
+  uint64_t advance();
+  //! value reserved by the last call to advance(), 0 before
+  uint64_t last_value() const;
+
+  //! value of the most recent submission that finished on the GPU
+  uint64_t completed_value() const;
+  bool is_complete(uint64_t value) const;
+  //! blocks until the submission that signals \p value has finished,
+  //! returns immediately for 0
+  void wait(uint64_t value) const;
+
+private:
+  VkDevice device;
+  VkSemaphore semaphore = VK_NULL_HANDLE;
+  uint64_t reserved_value = 0;
+};
+
+#endif // FRAME_TIMELINE_HPP
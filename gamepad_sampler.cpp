@@ -0,0 +1,110 @@
+#include "gamepad_sampler.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+GamepadSampler::GamepadSampler(double rate, float sensitivity) :
+    sample_interval{rate > 0.0 ? 1.0 / rate : 0.0},
+    sensitivity{sensitivity}
+{
+  if (rate <= 0.0) {
+    throw std::invalid_argument("sample rate must be positive!");
+  }
+}
+
+double GamepadSampler::poll(double now)
+{
+  if (now < next_sample)
+    return next_sample - now;
+
+  for (int joystick = GLFW_JOYSTICK_1; joystick <= GLFW_JOYSTICK_LAST; ++joystick) {
+    GLFWgamepadstate glfw_state;
+    if (glfwJoystickIsGamepad(joystick) == GLFW_TRUE && glfwGetGamepadState(joystick, &glfw_state) == GLFW_TRUE) {
+      GamepadState state;
+      for (int button = 0; button <= GLFW_GAMEPAD_BUTTON_LAST; ++button) {
+        if (glfw_state.buttons[button] == GLFW_PRESS)
+          state.buttons |= uint32_t{1} << button;
+      }
+      for (int axis = 0; axis <= GLFW_GAMEPAD_AXIS_LAST; ++axis)
+        state.axes[static_cast<std::size_t>(axis)] = glfw_state.axes[axis];
+
+      update(joystick, now, state);
+    } else {
+      disconnect(joystick, now);
+    }
+  }
+
+  // a late sample does not cause a burst of samples to catch up
+  next_sample += sample_interval;
+  if (next_sample <= now)
+    next_sample = now + sample_interval;
+
+  return next_sample - now;
+}
+
+void GamepadSampler::update(int joystick, double time, const GamepadState& state)
+{
+  auto& current = joysticks.at(static_cast<std::size_t>(joystick));
+  if (!current.connected) {
+    // the first sample is the reference for the following ones
+    current.connected = true;
+    current.state = state;
+    current.reported_axes = state.axes;
+    publish({time, joystick, GamepadEvent::Type::CONNECTED, 0, 0.0f});
+    return;
+  }
+
+  // every bit that differs is an edge, however many buttons changed
+  // within one sample
+  const uint32_t changed = current.state.buttons ^ state.buttons;
+  if (changed != 0) {
+    for (int button = 0; button <= GLFW_GAMEPAD_BUTTON_LAST; ++button) {
+      const uint32_t mask = uint32_t{1} << button;
+      if (changed & mask) {
+        publish({time, joystick,
+                 (state.buttons & mask) ? GamepadEvent::Type::BUTTON_PRESSED : GamepadEvent::Type::BUTTON_RELEASED,
+                 button, 0.0f});
+      }
+    }
+  }
+
+  for (std::size_t axis = 0; axis < state.axes.size(); ++axis) {
+    if (std::fabs(state.axes[axis] - current.reported_axes[axis]) >= sensitivity) {
+      current.reported_axes[axis] = state.axes[axis];
+      publish({time, joystick, GamepadEvent::Type::AXIS_MOVED, static_cast<int>(axis), state.axes[axis]});
+    }
+  }
+
+  current.state = state;
+}
+
+void GamepadSampler::disconnect(int joystick, double time)
+{
+  auto& current = joysticks.at(static_cast<std::size_t>(joystick));
+  if (!current.connected)
+    return;
+
+  current = Joystick{};
+  publish({time, joystick, GamepadEvent::Type::DISCONNECTED, 0, 0.0f});
+}
+
+std::optional<GamepadEvent> GamepadSampler::next_event()
+{
+  return events.try_pop();
+}
+
+double GamepadSampler::interval() const
+{
+  return sample_interval;
+}
+
+uint64_t GamepadSampler::dropped_events() const
+{
+  return dropped;
+}
+
+void GamepadSampler::publish(const GamepadEvent& event)
+{
+  if (!events.try_push(event))
+    ++dropped;
+}
@@ -0,0 +1,91 @@
+#ifndef GAMEPAD_SAMPLER_HPP
+#define GAMEPAD_SAMPLER_HPP
+
+#include "spsc_queue.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+//! the gamepad state of one joystick with the buttons packed into a
+//! bitmask, bit i is set while GLFW gamepad button i is held
+struct GamepadState
+{
+  uint32_t buttons = 0;
+  std::array<float, GLFW_GAMEPAD_AXIS_LAST + 1> axes{};
+};
+
+struct GamepadEvent
+{
+  enum class Type
+  {
+    CONNECTED,
+    DISCONNECTED,
+    BUTTON_PRESSED,
+    BUTTON_RELEASED,
+    AXIS_MOVED,
+  };
+
+  //! seconds on the clock passed to poll()
+  double time;
+  int joystick;
+  Type type;
+  //! button or axis, 0 for connection changes
+  int index;
+  //! axis position, 0 for buttons and connection changes
+  float value;
+};
+
+//! samples every connected gamepad at a fixed rate and turns the
+//! changes into events
+//!
+//! GLFW only allows joystick queries on the main thread, so poll() has
+//! to be called from there, e.g. between glfwWaitEventsTimeout() calls
+//! with the returned timeout. The events are read by a single consumer
+//! thread, which may be the main thread as well.
+class GamepadSampler
+{
+public:
+  //! axes are reported once they moved by at least \p sensitivity
+  //! since they were reported last
+  static constexpr float SENSITIVITY = 0.1f;
+
+  explicit GamepadSampler(double rate, float sensitivity = SENSITIVITY);
+
+  //! samples all joysticks if a sample is due at \p now and returns
+  //! the seconds until the next one
+  double poll(double now);
+  //! feeds one sample of \p joystick, poll() calls it for every
+  //! connected gamepad
+  void update(int joystick, double time, const GamepadState& state);
+  void disconnect(int joystick, double time);
+
+  //! consumer side
+  std::optional<GamepadEvent> next_event();
+
+  double interval() const;
+  //! events lost because the consumer fell behind
+  uint64_t dropped_events() const;
+
+private:
+  struct Joystick
+  {
+    bool connected = false;
+    GamepadState state;
+    //! axis positions as last reported
+    std::array<float, GLFW_GAMEPAD_AXIS_LAST + 1> reported_axes{};
+  };
+
+  void publish(const GamepadEvent& event);
+
+  double sample_interval;
+  float sensitivity;
+  double next_sample = 0.0;
+  std::array<Joystick, GLFW_JOYSTICK_LAST + 1> joysticks;
+  SpscQueue<GamepadEvent, 4096> events;
+  uint64_t dropped = 0;
+};
+
+#endif // GAMEPAD_SAMPLER_HPP
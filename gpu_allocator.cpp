@@ -0,0 +1,203 @@
+#include "gpu_allocator.hpp"
+
+#include "vulkan_memory.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+  VkDeviceSize round_up_to_power_of_two(VkDeviceSize value)
+  {
+    VkDeviceSize result = 1;
+    while (result < value) {
+      result *= 2;
+    }
+
+    return result;
+  }
+}
+
+GpuAllocator::GpuAllocator(VkDevice device,
+                           VkPhysicalDevice physical_device,
+                           AllocationStrategy strategy,
+                           VkDeviceSize block_size) :
+    device{device},
+    strategy{strategy},
+    block_size{block_size}
+{
+  vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+  buffer_image_granularity = properties.limits.bufferImageGranularity;
+}
+
+GpuAllocator::~GpuAllocator()
+{
+  for (auto& [key, blocks] : pools) {
+    for (auto& block : blocks) {
+      destroy_block(block);
+    }
+  }
+}
+
+GpuAllocator::Block GpuAllocator::create_block(uint32_t memory_type_index, VkDeviceSize size)
+{
+  std::unique_ptr<Suballocator> suballocator;
+  if (strategy == AllocationStrategy::BUDDY) {
+    size = round_up_to_power_of_two(size);
+    suballocator = std::make_unique<BuddySuballocator>(size);
+  } else {
+    suballocator = std::make_unique<FreeListSuballocator>(size);
+  }
+
+  VkMemoryAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = size;
+  alloc_info.memoryTypeIndex = memory_type_index;
+
+  VkDeviceMemory memory;
+  if (vkAllocateMemory(device, &alloc_info, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate memory block!");
+  }
+
+  void* mapped = nullptr;
+  if (mem_properties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+      vkFreeMemory(device, memory, nullptr);
+      throw std::runtime_error("failed to map memory block!");
+    }
+  }
+
+  return {memory, mapped, std::move(suballocator)};
+}
+
+void GpuAllocator::destroy_block(Block& block)
+{
+  // freeing implicitly unmaps the memory
+  vkFreeMemory(device, block.memory, nullptr);
+  block.memory = VK_NULL_HANDLE;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& requirements,
+                                     VkMemoryPropertyFlags properties,
+                                     ResourceKind kind)
+{
+  const uint32_t memory_type_index = find_memory_type(mem_properties, requirements.memoryTypeBits, properties);
+  // without a granularity constraint buffers and images can share blocks
+  if (buffer_image_granularity <= 1)
+    kind = ResourceKind::LINEAR;
+
+  const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+  std::lock_guard<std::mutex> lock{mutex};
+  auto& blocks = pools[{memory_type_index, kind}];
+  for (auto& block : blocks) {
+    if (const auto offset = block.suballocator->allocate(requirements.size, alignment)) {
+      void* mapped = block.mapped ? static_cast<char*>(block.mapped) + *offset : nullptr;
+      return {block.memory, *offset, requirements.size, mapped, memory_type_index, kind};
+    }
+  }
+
+  // small heaps, like the host visible part of VRAM, get smaller
+  // blocks; requests larger than a block get a block of their own
+  const uint32_t heap_index = mem_properties.memoryTypes[memory_type_index].heapIndex;
+  const VkDeviceSize preferred_block_size = std::min(block_size, mem_properties.memoryHeaps[heap_index].size / 8);
+  blocks.push_back(create_block(memory_type_index, std::max(preferred_block_size, requirements.size)));
+  auto& block = blocks.back();
+  const auto offset = block.suballocator->allocate(requirements.size, alignment);
+  if (!offset) {
+    throw std::runtime_error("allocation does not fit into a new memory block");
+  }
+
+  void* mapped = block.mapped ? static_cast<char*>(block.mapped) + *offset : nullptr;
+  return {block.memory, *offset, requirements.size, mapped, memory_type_index, kind};
+}
+
+GpuAllocation GpuAllocator::allocate_buffer_memory(VkBuffer buffer, VkMemoryPropertyFlags properties)
+{
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+  const GpuAllocation allocation = allocate(requirements, properties, ResourceKind::LINEAR);
+  if (vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+    free(allocation);
+    throw std::runtime_error("failed to bind buffer memory!");
+  }
+
+  return allocation;
+}
+
+GpuAllocation GpuAllocator::allocate_image_memory(VkImage image, VkMemoryPropertyFlags properties)
+{
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(device, image, &requirements);
+
+  const GpuAllocation allocation = allocate(requirements, properties, ResourceKind::OPTIMAL);
+  if (vkBindImageMemory(device, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+    free(allocation);
+    throw std::runtime_error("failed to bind image memory!");
+  }
+
+  return allocation;
+}
+
+void GpuAllocator::free(const GpuAllocation& allocation)
+{
+  if (allocation.memory == VK_NULL_HANDLE)
+    return;
+
+  std::lock_guard<std::mutex> lock{mutex};
+  auto& blocks = pools.at({allocation.memory_type_index, allocation.kind});
+  const auto block = std::find_if(blocks.begin(), blocks.end(), [&allocation](const Block& block) {
+    return block.memory == allocation.memory;
+  });
+  if (block == blocks.end()) {
+    throw std::invalid_argument("allocation does not belong to this allocator");
+  }
+
+  block->suballocator->free(allocation.offset);
+
+  // keep one empty block per pool around to avoid allocation churn
+  if (block->suballocator->empty() && blocks.size() > 1) {
+    destroy_block(*block);
+    blocks.erase(block);
+  }
+}
+
+const VkPhysicalDeviceMemoryProperties& GpuAllocator::memory_properties() const
+{
+  return mem_properties;
+}
+
+GpuAllocatorStatistics GpuAllocator::statistics() const
+{
+  std::lock_guard<std::mutex> lock{mutex};
+
+  GpuAllocatorStatistics result{0, 0, 0, 0, 0.0};
+  VkDeviceSize largest_free_regions = 0;
+  for (const auto& [key, blocks] : pools) {
+    for (const auto& block : blocks) {
+      const auto block_statistics = block.suballocator->statistics();
+      ++result.block_count;
+      result.allocation_count += block_statistics.allocation_count;
+      result.capacity += block_statistics.capacity;
+      result.used += block_statistics.used;
+      largest_free_regions += block_statistics.largest_free_region;
+    }
+  }
+
+  const VkDeviceSize free = result.capacity - result.used;
+  if (free != 0)
+    result.fragmentation = 1.0 - static_cast<double>(largest_free_regions) / static_cast<double>(free);
+
+  return result;
+}
+
+void GpuAllocator::print_statistics(std::ostream& stream) const
+{
+  const auto s = statistics();
+  stream << "gpu memory: " << s.allocation_count << " allocations in " << s.block_count
+         << " blocks, " << s.used << " of " << s.capacity << " bytes used, fragmentation "
+         << s.fragmentation << '\n';
+}
@@ -0,0 +1,100 @@
+#ifndef GPU_ALLOCATOR_HPP
+#define GPU_ALLOCATOR_HPP
+
+#include "suballocator.hpp"
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+enum class AllocationStrategy
+{
+  FREE_LIST,
+  BUDDY,
+};
+
+//! buffers and linear images must not share a
+//! bufferImageGranularity page with optimal tiling images
+enum class ResourceKind
+{
+  LINEAR,
+  OPTIMAL,
+};
+
+struct GpuAllocation
+{
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  //! only set for host visible memory, which stays mapped
+  void* mapped = nullptr;
+  uint32_t memory_type_index = 0;
+  ResourceKind kind = ResourceKind::LINEAR;
+};
+
+struct GpuAllocatorStatistics
+{
+  std::size_t block_count;
+  std::size_t allocation_count;
+  VkDeviceSize capacity;
+  VkDeviceSize used;
+  double fragmentation;
+};
+
+//! allocates large VkDeviceMemory blocks per memory type and hands out
+//! ranges of them
+class GpuAllocator
+{
+public:
+  GpuAllocator(VkDevice device,
+               VkPhysicalDevice physical_device,
+               AllocationStrategy strategy = AllocationStrategy::FREE_LIST,
+               VkDeviceSize block_size = VkDeviceSize{64} * 1024 * 1024);
+  GpuAllocator(const GpuAllocator&) = delete;
+  GpuAllocator& operator=(const GpuAllocator&) = delete;
+  ~GpuAllocator();
+
+  GpuAllocation allocate(const VkMemoryRequirements& requirements,
+                         VkMemoryPropertyFlags properties,
+                         ResourceKind kind);
+  //! allocates memory for \p buffer and binds it
+  GpuAllocation allocate_buffer_memory(VkBuffer buffer, VkMemoryPropertyFlags properties);
+  //! allocates memory for \p image with optimal tiling and binds it
+  GpuAllocation allocate_image_memory(VkImage image, VkMemoryPropertyFlags properties);
+  void free(const GpuAllocation& allocation);
+
+  const VkPhysicalDeviceMemoryProperties& memory_properties() const;
+  GpuAllocatorStatistics statistics() const;
+  void print_statistics(std::ostream& stream) const;
+
+private:
+  struct Block
+  {
+    VkDeviceMemory memory;
+    void* mapped;
+    std::unique_ptr<Suballocator> suballocator;
+  };
+
+  //! memory type index and resource kind
+  using PoolKey = std::pair<uint32_t, ResourceKind>;
+
+  Block create_block(uint32_t memory_type_index, VkDeviceSize size);
+  void destroy_block(Block& block);
+
+  VkDevice device;
+  VkPhysicalDeviceMemoryProperties mem_properties;
+  VkDeviceSize buffer_image_granularity;
+  AllocationStrategy strategy;
+  VkDeviceSize block_size;
+  mutable std::mutex mutex;
+  std::map<PoolKey, std::vector<Block>> pools;
+};
+
+#endif // GPU_ALLOCATOR_HPP
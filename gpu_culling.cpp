@@ -0,0 +1,212 @@
+#include "gpu_culling.hpp"
+
+#include <stdexcept>
+
+namespace {
+  VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+  {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  VkBuffer create_buffer(VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage)
+  {
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create culling buffer!");
+    }
+
+    return buffer;
+  }
+}
+
+GpuCulling::GpuCulling(VkDevice device,
+                       GpuAllocator& allocator,
+                       VkPipelineCache pipeline_cache,
+                       VkShaderModule cull_shader,
+                       VkDeviceSize storage_buffer_alignment,
+                       VkBuffer object_buffer,
+                       uint32_t object_count,
+                       uint32_t vertex_count,
+                       uint32_t frames_in_flight) :
+    device{device},
+    allocator{allocator},
+    object_count{object_count},
+    vertex_count{vertex_count},
+    command_stride{align_up(VkDeviceSize{sizeof(VkDrawIndirectCommand)} * object_count, storage_buffer_alignment)},
+    count_stride{align_up(sizeof(uint32_t), storage_buffer_alignment)}
+{
+  if (object_count == 0) {
+    throw std::invalid_argument("culling needs at least one object");
+  }
+
+  try {
+    draw_command_buffer = create_buffer(device,
+                                        command_stride * frames_in_flight,
+                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    draw_command_allocation = allocator.allocate_buffer_memory(draw_command_buffer,
+                                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    count_buffer = create_buffer(device,
+                                 count_stride * frames_in_flight,
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    count_allocation = allocator.allocate_buffer_memory(count_buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // binding 0: objects, binding 1: draw commands, binding 2: draw count
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t binding = 0; binding < bindings.size(); ++binding) {
+      bindings[binding].binding = binding;
+      bindings[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      bindings[binding].descriptorCount = 1;
+      bindings[binding].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &descriptor_set_layout) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create culling descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = static_cast<uint32_t>(bindings.size()) * frames_in_flight;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = frames_in_flight;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create culling descriptor pool!");
+    }
+
+    const std::vector<VkDescriptorSetLayout> set_layouts(frames_in_flight, descriptor_set_layout);
+    VkDescriptorSetAllocateInfo set_info{};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = descriptor_pool;
+    set_info.descriptorSetCount = frames_in_flight;
+    set_info.pSetLayouts = set_layouts.data();
+    descriptor_sets.resize(frames_in_flight);
+    if (vkAllocateDescriptorSets(device, &set_info, descriptor_sets.data()) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate culling descriptor sets!");
+    }
+
+    for (uint32_t frame = 0; frame < frames_in_flight; ++frame) {
+      const std::array<VkDescriptorBufferInfo, 3> buffer_infos{{
+        {object_buffer, 0, VK_WHOLE_SIZE},
+        {draw_command_buffer, frame * command_stride, VkDeviceSize{sizeof(VkDrawIndirectCommand)} * object_count},
+        {count_buffer, frame * count_stride, sizeof(uint32_t)}
+      }};
+
+      std::array<VkWriteDescriptorSet, 3> writes{};
+      for (uint32_t binding = 0; binding < writes.size(); ++binding) {
+        writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[binding].dstSet = descriptor_sets[frame];
+        writes[binding].dstBinding = binding;
+        writes[binding].descriptorCount = 1;
+        writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[binding].pBufferInfo = &buffer_infos[binding];
+      }
+      vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+    if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create culling pipeline layout!");
+    }
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = cull_shader;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = pipeline_layout;
+    if (vkCreateComputePipelines(device, pipeline_cache, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create culling pipeline!");
+    }
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+GpuCulling::~GpuCulling()
+{
+  destroy();
+}
+
+void GpuCulling::destroy()
+{
+  vkDestroyPipeline(device, pipeline, nullptr);
+  vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+  // destroying the pool frees its descriptor sets
+  vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device, descriptor_set_layout, nullptr);
+  vkDestroyBuffer(device, count_buffer, nullptr);
+  allocator.free(count_allocation);
+  vkDestroyBuffer(device, draw_command_buffer, nullptr);
+  allocator.free(draw_command_allocation);
+}
+
+void GpuCulling::cull(VkCommandBuffer command_buffer, uint32_t frame, const std::array<float, 4>& view)
+{
+  vkCmdFillBuffer(command_buffer, count_buffer, frame * count_stride, sizeof(uint32_t), 0);
+
+  VkBufferMemoryBarrier reset_barrier{};
+  reset_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  reset_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  reset_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  reset_barrier.buffer = count_buffer;
+  reset_barrier.offset = frame * count_stride;
+  reset_barrier.size = sizeof(uint32_t);
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       0, 0, nullptr, 1, &reset_barrier, 0, nullptr);
+
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout,
+                          0, 1, &descriptor_sets[frame], 0, nullptr);
+
+  const PushConstants push_constants{view, object_count, vertex_count};
+  vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                     0, sizeof(push_constants), &push_constants);
+  vkCmdDispatch(command_buffer, (object_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+  VkMemoryBarrier draw_barrier{};
+  draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       0, 1, &draw_barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::draw(VkCommandBuffer command_buffer, uint32_t frame)
+{
+  vkCmdDrawIndirectCount(command_buffer,
+                         draw_command_buffer, frame * command_stride,
+                         count_buffer, frame * count_stride,
+                         object_count, sizeof(VkDrawIndirectCommand));
+}
@@ -0,0 +1,75 @@
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include "gpu_allocator.hpp"
+
+#include "vulkan/vulkan_core.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+//! culls an object list on the GPU and draws the survivors with
+//! vkCmdDrawIndirectCount
+//!
+//! A compute shader tests every object against the view rectangle and
+//! appends one VkDrawIndirectCommand per visible object, whose
+//! firstInstance selects the object in the instance rate vertex
+//! binding. Every frame in flight owns its own slice of the command
+//! and count buffers.
+class GpuCulling
+{
+public:
+  //! \p object_buffer holds \p object_count tightly packed objects of
+  //! 6 floats: offset x and y, scale and color
+  GpuCulling(VkDevice device,
+             GpuAllocator& allocator,
+             VkPipelineCache pipeline_cache,
+             VkShaderModule cull_shader,
+             VkDeviceSize storage_buffer_alignment,
+             VkBuffer object_buffer,
+             uint32_t object_count,
+             uint32_t vertex_count,
+             uint32_t frames_in_flight);
+  GpuCulling(const GpuCulling&) = delete;
+  GpuCulling& operator=(const GpuCulling&) = delete;
+  ~GpuCulling();
+
+  //! has to be recorded outside of a render pass, \p view is the
+  //! visible rectangle as min x, min y, max x, max y
+  void cull(VkCommandBuffer command_buffer, uint32_t frame, const std::array<float, 4>& view);
+  //! has to be recorded inside the render pass after binding the
+  //! graphics pipeline and the vertex buffers
+  void draw(VkCommandBuffer command_buffer, uint32_t frame);
+
+private:
+  struct PushConstants
+  {
+    std::array<float, 4> view;
+    uint32_t object_count;
+    uint32_t vertex_count;
+  };
+
+  static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+  void destroy();
+
+  VkDevice device;
+  GpuAllocator& allocator;
+  uint32_t object_count;
+  uint32_t vertex_count;
+  VkDeviceSize command_stride;
+  VkDeviceSize count_stride;
+
+  VkBuffer draw_command_buffer = VK_NULL_HANDLE;
+  GpuAllocation draw_command_allocation;
+  VkBuffer count_buffer = VK_NULL_HANDLE;
+  GpuAllocation count_allocation;
+  VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+  VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+  std::vector<VkDescriptorSet> descriptor_sets;
+  VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+};
+
+#endif // GPU_CULLING_HPP
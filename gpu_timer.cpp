@@ -0,0 +1,84 @@
+#include "gpu_timer.hpp"
+
+#include <array>
+#include <stdexcept>
+
+GpuTimer::GpuTimer(VkDevice device,
+                   float timestamp_period,
+                   uint32_t timestamp_valid_bits,
+                   uint32_t frames_in_flight,
+                   std::size_t history) :
+    device{device},
+    timestamp_period_ms{static_cast<double>(timestamp_period) / 1e6},
+    timestamp_mask{timestamp_valid_bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << timestamp_valid_bits) - 1},
+    pending(frames_in_flight, false),
+    frame_times{history}
+{
+  if (timestamp_valid_bits == 0) {
+    throw std::runtime_error("queue does not support timestamps");
+  }
+
+  VkQueryPoolCreateInfo create_info{};
+  create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  create_info.queryCount = frames_in_flight * QUERIES_PER_FRAME;
+
+  if (vkCreateQueryPool(device, &create_info, nullptr, &query_pool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create timestamp query pool!");
+  }
+}
+
+GpuTimer::~GpuTimer()
+{
+  vkDestroyQueryPool(device, query_pool, nullptr);
+}
+
+void GpuTimer::begin(VkCommandBuffer command_buffer, uint32_t frame)
+{
+  const uint32_t first_query = frame * QUERIES_PER_FRAME;
+  vkCmdResetQueryPool(command_buffer, query_pool, first_query, QUERIES_PER_FRAME);
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, first_query);
+}
+
+void GpuTimer::end(VkCommandBuffer command_buffer, uint32_t frame)
+{
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool,
+                      frame * QUERIES_PER_FRAME + 1);
+  pending[frame] = true;
+}
+
+void GpuTimer::collect(uint32_t frame)
+{
+  if (!pending[frame])
+    return;
+
+  std::array<uint64_t, QUERIES_PER_FRAME> timestamps{};
+  const VkResult result = vkGetQueryPoolResults(device,
+                                                query_pool,
+                                                frame * QUERIES_PER_FRAME,
+                                                QUERIES_PER_FRAME,
+                                                sizeof(timestamps),
+                                                timestamps.data(),
+                                                sizeof(uint64_t),
+                                                VK_QUERY_RESULT_64_BIT);
+  if (result == VK_NOT_READY)
+    return;
+  if (result != VK_SUCCESS)
+    throw std::runtime_error("failed to read timestamp queries!");
+
+  pending[frame] = false;
+  const uint64_t ticks = ((timestamps[1] & timestamp_mask) - (timestamps[0] & timestamp_mask)) & timestamp_mask;
+  frame_times.add(static_cast<double>(ticks) * timestamp_period_ms);
+}
+
+RollingStatistics::Summary GpuTimer::summary() const
+{
+  return frame_times.summary();
+}
+
+void GpuTimer::print(std::ostream& stream) const
+{
+  const auto s = summary();
+  stream << "gpu frame time over the last " << s.count << " frames (ms): min " << s.min
+         << ", avg " << s.avg << ", p99 " << s.p99 << ", max " << s.max << '\n';
+}
@@ -0,0 +1,53 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include "rolling_statistics.hpp"
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+//! measures the GPU time of each frame with timestamp queries
+//!
+//! Every frame in flight owns its own slice of the query pool. A
+//! slice is only read back after the fence of its frame has been
+//! waited on, so the readback never stalls.
+class GpuTimer
+{
+public:
+  GpuTimer(VkDevice device,
+           float timestamp_period,
+           uint32_t timestamp_valid_bits,
+           uint32_t frames_in_flight,
+           std::size_t history = 1024);
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+  ~GpuTimer();
+
+  //! has to be recorded outside of a render pass
+  void begin(VkCommandBuffer command_buffer, uint32_t frame);
+  void end(VkCommandBuffer command_buffer, uint32_t frame);
+
+  //! reads back the last result of \p frame, call it only after the
+  //! fence of that frame has been signaled
+  void collect(uint32_t frame);
+
+  //! frame times in milliseconds
+  RollingStatistics::Summary summary() const;
+  void print(std::ostream& stream) const;
+
+private:
+  static constexpr uint32_t QUERIES_PER_FRAME = 2;
+
+  VkDevice device;
+  VkQueryPool query_pool = VK_NULL_HANDLE;
+  double timestamp_period_ms;
+  uint64_t timestamp_mask;
+  std::vector<bool> pending;
+  RollingStatistics frame_times;
+};
+
+#endif // GPU_TIMER_HPP
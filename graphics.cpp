@@ -43,11 +43,31 @@ void GraphicsContext::pool_events()
   glfwPollEvents();
 }
 
+void GraphicsContext::wait_events()
+{
+  glfwWaitEvents();
+}
+
+void GraphicsContext::wait_events_timeout(double timeout)
+{
+  glfwWaitEventsTimeout(timeout);
+}
+
+void GraphicsContext::post_empty_event()
+{
+  glfwPostEmptyEvent();
+}
+
 void GraphicsContext::set_window_floating_hint(bool floating)
 {
   glfwWindowHint(GLFW_FLOATING, floating ? GLFW_TRUE : GLFW_FALSE);
 }
 
+void GraphicsContext::set_window_resizable_hint(bool resizable)
+{
+  glfwWindowHint(GLFW_RESIZABLE, resizable ? GLFW_TRUE : GLFW_FALSE);
+}
+
 double GraphicsContext::time()
 {
   return glfwGetTime();
@@ -77,6 +97,11 @@ void Window::set_key_callback(void (*callback)(GLFWwindow*, int, int, int, int))
   glfwSetKeyCallback(window.get(), callback);
 }
 
+void Window::set_framebuffer_size_callback(void (*callback)(GLFWwindow*, int, int))
+{
+  glfwSetFramebufferSizeCallback(window.get(), callback);
+}
+
 void Window::make_context_current()
 {
   glfwMakeContextCurrent(window.get());
@@ -27,7 +27,12 @@ public:
   void clear();
   bool vulkan_supported() const;
   void pool_events();
+  void wait_events();
+  void wait_events_timeout(double timeout);
+  //! wakes up wait_events(), may be called from any thread
+  void post_empty_event();
   void set_window_floating_hint(bool floating);
+  void set_window_resizable_hint(bool resizable);
   double time();
 };
 
@@ -39,6 +44,7 @@ public:
   VkSurfaceKHR create_window_surface(VkInstance instance);
 
   void set_key_callback(void (*callback)(GLFWwindow*, int, int, int, int));
+  void set_framebuffer_size_callback(void (*callback)(GLFWwindow*, int, int));
   void make_context_current();
   void request_window_attention();
   void set_should_close(bool should_close);
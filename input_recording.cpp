@@ -0,0 +1,138 @@
+#include "input_recording.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "OS not supported yet"
+#endif
+
+GamepadEvent input_recording::to_gamepad_event(const Record& record)
+{
+  return {record.time, record.code, static_cast<GamepadEvent::Type>(record.action), record.index, record.value};
+}
+
+InputRecorder::InputRecorder(const std::filesystem::path& path) :
+    path{path},
+    file{path, std::ios::binary | std::ios::trunc}
+{
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to create input recording \"" + path.string() + "\"!");
+  }
+
+  input_recording::Header header{};
+  std::memcpy(header.magic, input_recording::MAGIC, sizeof(header.magic));
+  header.version = input_recording::VERSION;
+  header.record_size = sizeof(input_recording::Record);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void InputRecorder::record_key(double time, int key, int action)
+{
+  write({time, input_recording::RecordType::KEY, key, action, 0, 0.0f, 0});
+}
+
+void InputRecorder::record_resize(double time, int width, int height)
+{
+  write({time, input_recording::RecordType::RESIZE, width, height, 0, 0.0f, 0});
+}
+
+void InputRecorder::record_gamepad(double time, const GamepadEvent& event)
+{
+  write({time, input_recording::RecordType::GAMEPAD, event.joystick, static_cast<int32_t>(event.type),
+         event.index, event.value, 0});
+}
+
+void InputRecorder::flush()
+{
+  file.flush();
+  if (!file) {
+    throw std::runtime_error("failed to write input recording \"" + path.string() + "\"!");
+  }
+}
+
+void InputRecorder::write(const input_recording::Record& record)
+{
+  // buffered by the stream, a record costs a copy
+  file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+InputPlayback::InputPlayback(const std::filesystem::path& path)
+{
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw std::runtime_error("failed to open input recording \"" + path.string() + "\"!");
+  }
+
+  struct stat file_status;
+  if (fstat(fd, &file_status) == -1) {
+    close(fd);
+    throw std::runtime_error("failed to stat input recording \"" + path.string() + "\"!");
+  }
+
+  mapping_size = static_cast<std::size_t>(file_status.st_size);
+  if (mapping_size < sizeof(input_recording::Header)) {
+    close(fd);
+    throw std::runtime_error("input recording \"" + path.string() + "\" is truncated!");
+  }
+
+  mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw std::runtime_error("failed to map input recording \"" + path.string() + "\"!");
+  }
+
+  // records are read in order exactly once
+  madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+
+  input_recording::Header header;
+  std::memcpy(&header, mapping, sizeof(header));
+  const std::size_t records_size = mapping_size - sizeof(header);
+  if (std::memcmp(header.magic, input_recording::MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != input_recording::VERSION ||
+      header.record_size != sizeof(input_recording::Record) ||
+      records_size % sizeof(input_recording::Record) != 0) {
+    munmap(mapping, mapping_size);
+    throw std::runtime_error("\"" + path.string() + "\" is not a supported input recording!");
+  }
+
+  records = reinterpret_cast<const input_recording::Record*>(static_cast<const char*>(mapping) + sizeof(header));
+  record_count = records_size / sizeof(input_recording::Record);
+}
+
+InputPlayback::~InputPlayback()
+{
+  munmap(mapping, mapping_size);
+}
+
+const input_recording::Record* InputPlayback::next(double time)
+{
+  if (position == record_count || records[position].time > time)
+    return nullptr;
+
+  return &records[position++];
+}
+
+std::optional<double> InputPlayback::next_time() const
+{
+  if (position == record_count)
+    return std::nullopt;
+
+  return records[position].time;
+}
+
+bool InputPlayback::finished() const
+{
+  return position == record_count;
+}
+
+std::size_t InputPlayback::size() const
+{
+  return record_count;
+}
@@ -0,0 +1,100 @@
+#ifndef INPUT_RECORDING_HPP
+#define INPUT_RECORDING_HPP
+
+#include "gamepad_sampler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+//! Input recordings are a header followed by fixed size records in
+//! the order of their time stamps. All integers are stored in host
+//! byte order.
+namespace input_recording {
+  constexpr char MAGIC[8] = {'V', 'K', 'I', 'N', 'P', 'U', 'T', 'S'};
+  constexpr uint32_t VERSION = 1;
+
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+  };
+
+  enum class RecordType : uint32_t
+  {
+    KEY,
+    GAMEPAD,
+    RESIZE,
+  };
+
+  struct Record
+  {
+    //! seconds since the recording started
+    double time;
+    RecordType type;
+    //! key, joystick or framebuffer width
+    int32_t code;
+    //! key action, GamepadEvent::Type or framebuffer height
+    int32_t action;
+    //! gamepad button or axis
+    int32_t index;
+    //! axis position
+    float value;
+    uint32_t reserved;
+  };
+
+  GamepadEvent to_gamepad_event(const Record& record);
+}
+
+//! appends input events to a recording
+class InputRecorder
+{
+public:
+  explicit InputRecorder(const std::filesystem::path& path);
+
+  void record_key(double time, int key, int action);
+  void record_resize(double time, int width, int height);
+  //! \p time replaces the time of \p event
+  void record_gamepad(double time, const GamepadEvent& event);
+  void flush();
+
+private:
+  void write(const input_recording::Record& record);
+
+  std::filesystem::path path;
+  std::ofstream file;
+};
+
+//! maps a recording into memory and hands out its records once they
+//! are due
+//!
+//! The caller decides what time means, wall clock time replays the
+//! input as it was recorded, a time derived from the frame count
+//! replays it as fast as the frames render.
+class InputPlayback
+{
+public:
+  explicit InputPlayback(const std::filesystem::path& path);
+  InputPlayback(const InputPlayback&) = delete;
+  InputPlayback& operator=(const InputPlayback&) = delete;
+  ~InputPlayback();
+
+  //! the next record if it is due at \p time, nullptr otherwise
+  const input_recording::Record* next(double time);
+  //! time of the next record, nullopt once all were handed out
+  std::optional<double> next_time() const;
+  bool finished() const;
+  std::size_t size() const;
+
+private:
+  void* mapping = nullptr;
+  std::size_t mapping_size = 0;
+  const input_recording::Record* records = nullptr;
+  std::size_t record_count = 0;
+  std::size_t position = 0;
+};
+
+#endif // INPUT_RECORDING_HPP
@@ -1,39 +1,33 @@
+#include "gamepad_sampler.hpp"
 #include "graphics.hpp"
+#include "input_recording.hpp"
 
 #include "GLFW/glfw3.h"
 
-#include <cmath>
+#include "cxxopts.hpp"
+
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <exception>
 #include <ios>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <ostream>
+#include <string>
 
 static bool quit = false;
 static bool attention = false;
+static InputRecorder* recorder = nullptr;
+static double start_time = 0.0;
 
 static void error_callback(int code, const char* description)
 {
   std::cerr << "error: " << code << ", " << description << '\n';
 }
 
-static void joystick_callback(int jid, int event)
-{
-  std::cout << "joystick event\n";
-  if (event == GLFW_CONNECTED) {
-    // The joystick was connected
-
-    std::cout << "joystick connected\n";
-  } else if (event == GLFW_DISCONNECTED) {
-    // The joystick was disconnected
-
-    std::cout << "joystick disconnected\n";
-  }
-
-  std::cout << std::endl;
-}
-
-static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+static void handle_key(int key, int action)
 {
   if (key == GLFW_KEY_Q && action == GLFW_PRESS)
     quit = true;
@@ -41,107 +35,124 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     attention = true;
 }
 
-struct Pos
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-  float x;
-  float y;
+  if (recorder != nullptr)
+    recorder->record_key(glfwGetTime() - start_time, key, action);
+
+  handle_key(key, action);
+}
+
+static const std::array<const char*, GLFW_GAMEPAD_BUTTON_LAST + 1> button_names = {
+  "button A", "button B", "button X", "button Y",
+  "left bumper", "right bumper", "back", "start", "guide",
+  "left thumb", "right thumb",
+  "dpad up", "dpad right", "dpad down", "dpad left"
+};
+
+static const std::array<const char*, GLFW_GAMEPAD_AXIS_LAST + 1> axis_names = {
+  "left x", "left y", "right x", "right y", "left trigger", "right trigger"
 };
 
-std::ostream& operator<< (std::ostream& stream, const Pos& pos)
+std::ostream& operator<< (std::ostream& stream, const GamepadEvent& event)
 {
-  stream << "(" << pos.x << ", " << pos.y << ")";
+  stream << event.time << " gamepad " << event.joystick << ": ";
+  switch (event.type) {
+  case GamepadEvent::Type::CONNECTED: {
+    const char* name = glfwGetGamepadName(event.joystick);
+    stream << "connected " << (name != nullptr ? name : "");
+    break;
+  }
+  case GamepadEvent::Type::DISCONNECTED:
+    stream << "disconnected";
+    break;
+  case GamepadEvent::Type::BUTTON_PRESSED:
+    stream << button_names[static_cast<std::size_t>(event.index)] << " pressed";
+    break;
+  case GamepadEvent::Type::BUTTON_RELEASED:
+    stream << button_names[static_cast<std::size_t>(event.index)] << " released";
+    break;
+  case GamepadEvent::Type::AXIS_MOVED:
+    stream << axis_names[static_cast<std::size_t>(event.index)] << ' ' << event.value;
+    break;
+  }
   return stream;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+  cxxopts::Options options(argv[0], "prints the input of every connected gamepad");
+  options.add_options()
+    ("r,rate", "gamepad samples per second", cxxopts::value<double>()->default_value("1000"))
+    ("record", "record the key and gamepad events into this file", cxxopts::value<std::string>())
+    ("replay", "replay a recording instead of reading the gamepads, exits at its end", cxxopts::value<std::string>())
+    ("replay-fast", "replay without waiting for the recorded times", cxxopts::value<bool>()->default_value("false"))
+    ("h,help", "Print usage");
+
   try {
+    const auto parse_result = options.parse(argc, argv);
+    if (parse_result.count("help")) {
+      std::cout << options.help() << std::endl;
+      return EXIT_SUCCESS;
+    }
+
     GraphicsContext context(ClientAPI::OPENGL);
     glfwSetErrorCallback(error_callback);
     Window window{640, 480, "Joystick"};
 
-    glfwSetJoystickCallback(joystick_callback);
     glfwSetKeyCallback(window.raw_glfw_window(), key_callback);
     window.make_context_current();
+    // nothing is drawn, the one swap maps the window so it gets the
+    // keyboard focus
+    window.swap_buffers();
 
     std::cout << std::boolalpha;
-    for (int joystick_id = 0; joystick_id < GLFW_JOYSTICK_LAST; joystick_id++) {
-      std::cout << "joy: " << (glfwJoystickPresent(joystick_id) == GLFW_TRUE) << '\n';
+    for (int joystick_id = GLFW_JOYSTICK_1; joystick_id <= GLFW_JOYSTICK_LAST; joystick_id++) {
+      std::cout << "joy " << joystick_id << ": " << (glfwJoystickPresent(joystick_id) == GLFW_TRUE)
+                << ", is gamepad: " << (glfwJoystickIsGamepad(joystick_id) == GLFW_TRUE) << '\n';
     }
 
-    std::cout << "is gamepad: " << glfwJoystickIsGamepad(GLFW_JOYSTICK_1) << '\n' <<
-      "gamepad name: " << glfwGetGamepadName(GLFW_JOYSTICK_1) << '\n';
-
-    GLFWgamepadstate state;
-    float axis_left_trigger_last_pos = -1.f;
-    float axis_right_trigger_last_pos = -1.f;
-    Pos axis_left_last_pos = { 0, 0 };
-    Pos axis_right_last_pos = { 0, 0 };
+    std::optional<InputRecorder> input_recorder;
+    if (parse_result.count("record")) {
+      input_recorder.emplace(parse_result["record"].as<std::string>());
+      recorder = &*input_recorder;
+    }
+    std::optional<InputPlayback> playback;
+    if (parse_result.count("replay"))
+      playback.emplace(parse_result["replay"].as<std::string>());
+    const bool replay_fast = parse_result["replay-fast"].as<bool>();
+
+    // the sample rate sets the pace of the loop instead of the display
+    GamepadSampler sampler{parse_result["rate"].as<double>()};
+    start_time = context.time();
     while (!window.should_close()) {
-      // Keep running
-      if (glfwGetGamepadState(GLFW_JOYSTICK_1, &state)) {
-        if (state.buttons[GLFW_GAMEPAD_BUTTON_A]) {
-          std::cout << "gamepad button A\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_B]) {
-          std::cout << "gamepad button B\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_X]) {
-          std::cout << "gamepad button X\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_Y]) {
-          std::cout << "gamepad button Y\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_LEFT_BUMPER]) {
-          std::cout << "gamepad left bumper\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_RIGHT_BUMPER]) {
-          std::cout << "gamepad right bumper\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_GUIDE]) {
-          std::cout << "gamepad guide\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_START]) {
-          std::cout << "gamepad start\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_BACK]) {
-          std::cout << "gamepad back\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_LEFT_THUMB]) {
-          std::cout << "gamepad left thumb\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_RIGHT_THUMB]) {
-          std::cout << "gamepad right thumb\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_DPAD_UP]) {
-          std::cout << "gamepad dpad up\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_DPAD_RIGHT]) {
-          std::cout << "gamepad dpad right\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_DPAD_DOWN]) {
-          std::cout << "gamepad dpad down\n";
-        } else if (state.buttons[GLFW_GAMEPAD_BUTTON_DPAD_LEFT]) {
-          std::cout << "gamepad dpad left\n";
+      if (playback) {
+        if (playback->finished())
+          break;
+
+        double now = std::numeric_limits<double>::infinity();
+        if (replay_fast) {
+          context.pool_events();
+        } else {
+          context.wait_events_timeout(std::max(*playback->next_time() - (context.time() - start_time), 0.0));
+          now = context.time() - start_time;
         }
 
-        constexpr float SENSITIVITY = .1f;
-
-        const float axis_left_trigger_current_pos = state.axes[GLFW_GAMEPAD_AXIS_LEFT_TRIGGER];
-        const float axis_right_trigger_current_pos = state.axes[GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER];
-
-        if (std::fabs(axis_left_trigger_current_pos - axis_left_trigger_last_pos) >= SENSITIVITY ||
-            std::fabs(axis_right_trigger_current_pos - axis_right_trigger_last_pos) >= SENSITIVITY) {
-          std::cout << "left/right trigger: " << state.axes[GLFW_GAMEPAD_AXIS_LEFT_TRIGGER] << ", "
-                    << state.axes[GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER] << '\n';
-          axis_left_trigger_last_pos = axis_left_trigger_current_pos;
-          axis_right_trigger_last_pos = axis_right_trigger_current_pos;
+        while (const auto* record = playback->next(now)) {
+          if (record->type == input_recording::RecordType::KEY)
+            handle_key(record->code, record->action);
+          else if (record->type == input_recording::RecordType::GAMEPAD)
+            std::cout << input_recording::to_gamepad_event(*record) << '\n';
         }
+      } else {
+        context.wait_events_timeout(sampler.poll(context.time()));
 
-        const Pos axis_left_current_pos = { state.axes[GLFW_GAMEPAD_AXIS_LEFT_X], state.axes[GLFW_GAMEPAD_AXIS_LEFT_Y] };
-        const Pos axis_right_current_pos = { state.axes[GLFW_GAMEPAD_AXIS_RIGHT_X], state.axes[GLFW_GAMEPAD_AXIS_RIGHT_Y] };
-
-        if (std::fabs(axis_left_current_pos.x - axis_left_last_pos.x) >= SENSITIVITY ||
-            std::fabs(axis_left_current_pos.y - axis_left_last_pos.y) >= SENSITIVITY) {
-          std::cout << "gamepad left: " << axis_left_current_pos << '\n';
+        while (const auto event = sampler.next_event()) {
+          if (input_recorder)
+            input_recorder->record_gamepad(event->time - start_time, *event);
+          std::cout << *event << '\n';
         }
-        axis_left_last_pos = axis_left_current_pos;
-
-        if (std::fabs(axis_right_current_pos.x - axis_right_last_pos.x) >= SENSITIVITY ||
-            std::fabs(axis_right_current_pos.y - axis_right_last_pos.y) >= SENSITIVITY) {
-          std::cout << "gamepad right: " << axis_right_current_pos << '\n';
-        }
-        axis_right_last_pos = axis_right_current_pos;
       }
-      window.swap_buffers();
-      context.pool_events();
 
       if (quit)
         window.set_should_close(true);
@@ -151,6 +162,13 @@ int main()
         attention = false;
       }
     }
+
+    if (sampler.dropped_events() != 0)
+      std::cout << "dropped " << sampler.dropped_events() << " gamepad events\n";
+
+    recorder = nullptr;
+    if (input_recorder)
+      input_recorder->flush();
   } catch (const std::exception &e) {
     std::cerr << e.what() << '\n';
     return EXIT_FAILURE;
@@ -2,8 +2,26 @@
 // https://www.glfw.org/docs/latest/vulkan_guide.html
 
 #include "allocator.hpp"
+#include "embedded_shaders.hpp"
 #include "executable_info.hpp"
+#include "file_watcher.hpp"
+#include "frame_limiter.hpp"
+#include "frame_timeline.hpp"
+#include "gpu_allocator.hpp"
+#include "gpu_culling.hpp"
+#include "gpu_timer.hpp"
 #include "graphics.hpp"
+#include "input_recording.hpp"
+#include "monitor_database.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_cache.hpp"
+#include "pipeline_variant_cache.hpp"
+#include "profiler.hpp"
+#include "rolling_statistics.hpp"
+#include "spsc_queue.hpp"
+#include "staging_uploader.hpp"
+#include "uniform_ring.hpp"
+#include "worker_pool.hpp"
 
 #define VK_USE_PLATFORM_WAYLAND_KHR
 #include "vulkan/vulkan.h"
@@ -16,17 +34,26 @@
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
 
 #include "cxxopts.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <csignal>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <iterator>
@@ -37,6 +64,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -89,12 +117,421 @@ struct Vertex {
   }
 };
 
+//! per-instance attributes of the instanced stress mode, read from
+//! binding 1 at instance rate by vert_instanced.glsl
+struct Instance {
+  glm::vec2 offset;
+  float scale;
+  glm::vec3 color;
+
+  static VkVertexInputBindingDescription getBindingDescription()
+  {
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = 1;
+    bindingDescription.stride = sizeof(Instance);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    return bindingDescription;
+  }
+
+  static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
+  {
+    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+    attributeDescriptions[0].binding = 1;
+    attributeDescriptions[0].location = 2;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[0].offset = offsetof(Instance, offset);
+
+    attributeDescriptions[1].binding = 1;
+    attributeDescriptions[1].location = 3;
+    attributeDescriptions[1].format = VK_FORMAT_R32_SFLOAT;
+    attributeDescriptions[1].offset = offsetof(Instance, scale);
+
+    attributeDescriptions[2].binding = 1;
+    attributeDescriptions[2].location = 4;
+    attributeDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributeDescriptions[2].offset = offsetof(Instance, color);
+
+    return attributeDescriptions;
+  }
+};
+
+//! the FrameUniforms block of the vertex shaders, written into the
+//! uniform ring once per frame
+struct FrameUniforms {
+  //! scale in xy, offset in zw
+  glm::vec4 transform;
+  float time;
+};
+
+//! the DrawConstants push constant block of the vertex shaders
+struct DrawConstants {
+  glm::vec4 tint;
+};
+
 const std::vector<Vertex> vertices = {
   {{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
   {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}},
   {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}
 };
 
+//! lays out count instances on a square grid covering
+//! [-extent, extent] in clip space
+static std::vector<Instance> make_instances(uint32_t count, float extent)
+{
+  std::vector<Instance> instances;
+  instances.reserve(count);
+
+  const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  const float cell = 2.0f * extent / static_cast<float>(side);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint32_t column = i % side;
+    const uint32_t row = i / side;
+    Instance instance{};
+    instance.offset = {-extent + cell * (static_cast<float>(column) + 0.5f),
+                       -extent + cell * (static_cast<float>(row) + 0.5f)};
+    instance.scale = cell;
+    instance.color = {0.25f + 0.75f * static_cast<float>(column) / static_cast<float>(side),
+                      0.25f + 0.75f * static_cast<float>(row) / static_cast<float>(side),
+                      1.0f};
+    instances.push_back(instance);
+  }
+
+  return instances;
+}
+
+static VkShaderModule create_shader_module(VkDevice device, const uint32_t* code, size_t code_size)
+{
+  VkShaderModuleCreateInfo create_info{};
+  create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  create_info.codeSize = code_size;
+  // vkCreateShaderModule does not keep a reference to the code
+  create_info.pCode = code;
+
+  VkShaderModule shader_module;
+  if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create shader module!");
+  }
+
+  return shader_module;
+}
+
+static VkShaderModule create_shader_module(VkDevice device, const std::filesystem::path& path)
+{
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    std::ostringstream oss;
+    oss << "failed to open file \"" << path << '\"';
+    throw std::runtime_error(oss.str());
+  }
+  const size_t file_size = (size_t) file.tellg();
+  std::vector<char, AlignedAllocator<char, uint32_t>> code(file_size);
+  file.seekg(0);
+  file.read(code.data(), static_cast<std::streamsize>(file_size));
+
+  return create_shader_module(device, reinterpret_cast<const uint32_t*>(code.data()), code.size());
+}
+
+//! creates the module from the SPIR-V embedded at build time unless
+//! \p shader_dir overrides it with a directory of .spv files
+static VkShaderModule load_shader_module(VkDevice device,
+                                         const std::optional<std::filesystem::path>& shader_dir,
+                                         const std::string& name)
+{
+  PROFILE_ZONE("load shader module");
+  if (shader_dir)
+    return create_shader_module(device, *shader_dir / name);
+
+  const EmbeddedShader shader = find_embedded_shader(name);
+  if (shader.code == nullptr) {
+    throw std::runtime_error("shader \"" + name + "\" is not embedded!");
+  }
+
+  return create_shader_module(device, shader.code, shader.size);
+}
+
+//! creates the pipeline drawing the triangles with \p state, it uses
+//! dynamic rendering if the state has no render pass
+//!
+//! A non-zero \p library_parts creates a graphics pipeline library
+//! with only these parts, the state of the other parts is ignored and
+//! the shader module of a stage which is not built may be null. Only
+//! reads its arguments, so it may run on any thread as long as the
+//! shader modules outlive the call.
+static VkPipeline create_graphics_pipeline(VkDevice device,
+                                           VkPipelineCache pipeline_cache,
+                                           VkPipelineLayout pipeline_layout,
+                                           const PipelineState& state,
+                                           VkGraphicsPipelineLibraryFlagsEXT library_parts = 0)
+{
+  std::vector<VkPipelineShaderStageCreateInfo> shader_stages;
+  if (library_parts == 0 || (library_parts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)) {
+    VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
+    vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vert_shader_stage_info.module = state.vert_shader_module;
+    vert_shader_stage_info.pName = "main";
+    shader_stages.push_back(vert_shader_stage_info);
+  }
+  if (library_parts == 0 || (library_parts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)) {
+    VkPipelineShaderStageCreateInfo frag_shader_stage_info{};
+    frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    frag_shader_stage_info.module = state.frag_shader_module;
+    frag_shader_stage_info.pName = "main";
+    shader_stages.push_back(frag_shader_stage_info);
+  }
+
+  // the extended dynamic state of Vulkan 1.3 keeps the state which is
+  // set by record_draw_state() out of PipelineState
+  std::vector<VkDynamicState> dynamic_states{
+    VK_DYNAMIC_STATE_VIEWPORT,
+    VK_DYNAMIC_STATE_SCISSOR,
+    VK_DYNAMIC_STATE_CULL_MODE,
+    VK_DYNAMIC_STATE_FRONT_FACE,
+    VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+    VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE
+  };
+
+  VkPipelineDynamicStateCreateInfo dynamic_state{};
+  dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+  dynamic_state.pDynamicStates = dynamic_states.data();
+
+  VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+  vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+#if 0
+  vertex_input_info.vertexBindingDescriptionCount = 0;
+  vertex_input_info.pVertexBindingDescriptions = nullptr; // Optional
+  vertex_input_info.vertexAttributeDescriptionCount = 0;
+  vertex_input_info.pVertexAttributeDescriptions = nullptr; // Optional
+#endif
+
+  std::vector<VkVertexInputBindingDescription> bindingDescriptions{Vertex::getBindingDescription()};
+  std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+  for (const auto& attribute : Vertex::getAttributeDescriptions())
+    attributeDescriptions.push_back(attribute);
+
+  if (state.instanced) {
+    bindingDescriptions.push_back(Instance::getBindingDescription());
+    for (const auto& attribute : Instance::getAttributeDescriptions())
+      attributeDescriptions.push_back(attribute);
+  }
+
+  vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+  vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+  vertex_input_info.pVertexBindingDescriptions = bindingDescriptions.data();
+  vertex_input_info.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+  input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  // dynamic, but the topology class still has to match
+  input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  input_assembly.primitiveRestartEnable = VK_FALSE;
+
+  VkPipelineViewportStateCreateInfo viewport_state{};
+  viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  // viewport and scissor are dynamic state, only their count is baked
+  viewport_state.viewportCount = 1;
+  viewport_state.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rasterizer{};
+  rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizer.depthClampEnable = VK_FALSE;
+  rasterizer.rasterizerDiscardEnable = VK_FALSE;
+  rasterizer.polygonMode = state.polygon_mode;
+  rasterizer.lineWidth = 1.0f;
+  rasterizer.depthBiasEnable = VK_FALSE;
+  rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+  rasterizer.depthBiasClamp = 0.0f; // Optional
+  rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+  VkPipelineMultisampleStateCreateInfo multisampling{};
+  multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisampling.sampleShadingEnable = VK_FALSE;
+  multisampling.rasterizationSamples = state.samples;
+  multisampling.minSampleShading = 1.0f; // Optional
+  multisampling.pSampleMask = nullptr; // Optional
+  multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+  multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+  // without a render pass the fragment shader part needs it even
+  // though there is no depth attachment
+  VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+  depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depth_stencil.depthTestEnable = VK_FALSE;
+  depth_stencil.depthWriteEnable = VK_FALSE;
+  depth_stencil.stencilTestEnable = VK_FALSE;
+
+  VkPipelineColorBlendAttachmentState color_blend_attachment{};
+  color_blend_attachment.colorWriteMask = state.color_write_mask;
+  color_blend_attachment.blendEnable = state.blend_enable;
+  color_blend_attachment.srcColorBlendFactor = state.src_color_blend_factor;
+  color_blend_attachment.dstColorBlendFactor = state.dst_color_blend_factor;
+  color_blend_attachment.colorBlendOp = state.color_blend_op;
+  color_blend_attachment.srcAlphaBlendFactor = state.src_alpha_blend_factor;
+  color_blend_attachment.dstAlphaBlendFactor = state.dst_alpha_blend_factor;
+  color_blend_attachment.alphaBlendOp = state.alpha_blend_op;
+
+  VkPipelineColorBlendStateCreateInfo color_blending{};
+  color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  color_blending.logicOpEnable = VK_FALSE;
+  color_blending.logicOp = VK_LOGIC_OP_COPY; // Optional
+  color_blending.attachmentCount = 1;
+  color_blending.pAttachments = &color_blend_attachment;
+  color_blending.blendConstants[0] = 0.0f; // Optional
+  color_blending.blendConstants[1] = 0.0f; // Optional
+  color_blending.blendConstants[2] = 0.0f; // Optional
+  color_blending.blendConstants[3] = 0.0f; // Optional
+
+  VkGraphicsPipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipeline_info.stageCount = static_cast<uint32_t>(shader_stages.size());
+  pipeline_info.pStages = shader_stages.data();
+  pipeline_info.pVertexInputState = &vertex_input_info;
+  pipeline_info.pInputAssemblyState = &input_assembly;
+  pipeline_info.pViewportState = &viewport_state;
+  pipeline_info.pRasterizationState = &rasterizer;
+  pipeline_info.pMultisampleState = &multisampling;
+  pipeline_info.pDepthStencilState = &depth_stencil;
+  pipeline_info.pColorBlendState = &color_blending;
+  pipeline_info.pDynamicState = &dynamic_state;
+  pipeline_info.layout = pipeline_layout;
+  // without a render pass the attachment formats come from
+  // VkPipelineRenderingCreateInfo
+  VkPipelineRenderingCreateInfo rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachmentFormats = &state.color_format;
+  if (state.render_pass == VK_NULL_HANDLE)
+    pipeline_info.pNext = &rendering_info;
+  VkGraphicsPipelineLibraryCreateInfoEXT library_info{};
+  library_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+  library_info.flags = library_parts;
+  if (library_parts != 0) {
+    library_info.pNext = state.render_pass == VK_NULL_HANDLE ? &rendering_info : nullptr;
+    pipeline_info.pNext = &library_info;
+    pipeline_info.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+  }
+  pipeline_info.renderPass = state.render_pass;
+  pipeline_info.subpass = 0;
+  pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
+  pipeline_info.basePipelineIndex = -1; // Optional
+
+  VkPipeline temp_graphics_pipeline;
+  if (vkCreateGraphicsPipelines(device,
+                                pipeline_cache,
+                                1,
+                                &pipeline_info,
+                                nullptr,
+                                &temp_graphics_pipeline) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create graphics pipeline!");
+  }
+
+  return temp_graphics_pipeline;
+}
+
+//! links the vertex input, pre-rasterization, fragment shader and
+//! fragment output libraries into an executable pipeline
+//!
+//! Linking without link time optimization only combines the already
+//! compiled parts, which is what makes it fast. The pipeline does not
+//! reference the libraries once it has been created.
+static VkPipeline link_graphics_pipeline(VkDevice device,
+                                         VkPipelineCache pipeline_cache,
+                                         VkPipelineLayout pipeline_layout,
+                                         const std::array<VkPipeline, 4>& libraries)
+{
+  VkPipelineLibraryCreateInfoKHR library_info{};
+  library_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+  library_info.libraryCount = static_cast<uint32_t>(libraries.size());
+  library_info.pLibraries = libraries.data();
+
+  VkGraphicsPipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipeline_info.pNext = &library_info;
+  pipeline_info.layout = pipeline_layout;
+  pipeline_info.basePipelineIndex = -1;
+
+  VkPipeline temp_graphics_pipeline;
+  if (vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipeline_info, nullptr, &temp_graphics_pipeline) != VK_SUCCESS) {
+    throw std::runtime_error("failed to link graphics pipeline!");
+  }
+
+  return temp_graphics_pipeline;
+}
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+//! input received by the GLFW callbacks on the main thread, which only
+//! runs the event loop, and handled by the render thread
+struct InputEvent {
+  enum class Type {
+    KEY,
+    JOYSTICK,
+    RESIZE,
+  };
+
+  Type type;
+  //! key or joystick id
+  int code;
+  //! key action, or GLFW_CONNECTED or GLFW_DISCONNECTED
+  int action;
+  //! framebuffer size of a resize
+  int width;
+  int height;
+  //! GLFW time when the event arrived
+  double time;
+};
+
+// events are only dropped if the render thread stalls for a long time
+static SpscQueue<InputEvent, 1024> input_events;
+
+static void signal_handler(int signal)
+{
+  interrupted = 1;
+}
+
+//! maps the names accepted by --present-mode to present modes
+static std::optional<VkPresentModeKHR> parse_present_mode(const std::string& name)
+{
+  if (name == "immediate")
+    return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  if (name == "mailbox")
+    return VK_PRESENT_MODE_MAILBOX_KHR;
+  if (name == "fifo")
+    return VK_PRESENT_MODE_FIFO_KHR;
+  if (name == "fifo-relaxed")
+    return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+
+  return std::nullopt;
+}
+
+//! one image per frame in flight plus the one on screen, above 100 Hz
+//! another image absorbs the shorter time the compositor leaves
+static uint32_t swap_chain_image_count(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t frames_in_flight,
+                                       double refresh_period)
+{
+  uint32_t image_count = std::max(frames_in_flight + 1, capabilities.minImageCount);
+  if (refresh_period > 0.0 && refresh_period < 1.0 / 100.0)
+    ++image_count;
+  // a maxImageCount of 0 means there is no limit
+  if (capabilities.maxImageCount != 0)
+    image_count = std::min(image_count, capabilities.maxImageCount);
+
+  return image_count;
+}
+
+static std::filesystem::path default_pipeline_cache_path(const std::filesystem::path& executable_dir)
+{
+  const char* cache_home = std::getenv("XDG_CACHE_HOME");
+  if (cache_home != nullptr && *cache_home != '\0')
+    return std::filesystem::path{cache_home} / "vulkan_glfw" / "pipeline_cache.bin";
+
+  return executable_dir / "pipeline_cache.bin";
+}
+
 static void error_callback(int code, const char* description)
 {
   std::cerr << "error: " << code << ", " << description << '\n';
@@ -102,33 +539,210 @@ static void error_callback(int code, const char* description)
 
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-    glfwSetWindowShouldClose(window, GLFW_TRUE);
+  input_events.try_push({InputEvent::Type::KEY, key, action, 0, 0, glfwGetTime()});
+}
+
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+  input_events.try_push({InputEvent::Type::RESIZE, 0, 0, width, height, glfwGetTime()});
 }
 
 static void joystick_callback(int jid, int event)
 {
-  std::cout << "joystick event\n";
-  if (event == GLFW_CONNECTED) {
-    // The joystick was connected
+  input_events.try_push({InputEvent::Type::JOYSTICK, jid, event, 0, 0, glfwGetTime()});
+}
+
+//! where the draws of a frame find their uniforms
+struct FrameBindings {
+  VkPipelineLayout pipeline_layout;
+  VkDescriptorSet descriptor_set;
+  //! dynamic offset of the frame's range in the uniform ring
+  uint32_t uniform_offset;
+};
+
+//! binds the state every command buffer of the render pass needs,
+//! secondary command buffers do not inherit it
+static void record_draw_state(VkCommandBuffer command_buffer,
+                              VkPipeline graphics_pipeline,
+                              const FrameBindings& frame_bindings,
+                              const VkExtent2D& actual_extent,
+                              VkBuffer vertex_buffer,
+                              VkBuffer instance_buffer)
+{
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, frame_bindings.pipeline_layout,
+                          0, 1, &frame_bindings.descriptor_set, 1, &frame_bindings.uniform_offset);
+  const DrawConstants draw_constants{{1.0f, 1.0f, 1.0f, 1.0f}};
+  vkCmdPushConstants(command_buffer, frame_bindings.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT,
+                     0, sizeof(draw_constants), &draw_constants);
+  VkBuffer vertexBuffers[] = {vertex_buffer, instance_buffer};
+  VkDeviceSize offsets[] = {0, 0};
+  vkCmdBindVertexBuffers(command_buffer, 0, instance_buffer != VK_NULL_HANDLE ? 2 : 1, vertexBuffers, offsets);
+
+  VkViewport viewport{};
+  viewport.x = 0.0f;
+  viewport.y = 0.0f;
+  viewport.width = static_cast<float>(actual_extent.width);
+  viewport.height = static_cast<float>(actual_extent.height);
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+  VkRect2D scissor{};
+  scissor.offset = {0, 0};
+  scissor.extent = actual_extent;
+  vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+  vkCmdSetCullMode(command_buffer, VK_CULL_MODE_BACK_BIT);
+  vkCmdSetFrontFace(command_buffer, VK_FRONT_FACE_CLOCKWISE);
+  vkCmdSetPrimitiveTopology(command_buffer, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+  vkCmdSetPrimitiveRestartEnable(command_buffer, VK_FALSE);
+}
+
+//! records the draws [first, first + count) of the draw list, which
+//! holds one draw per instance or a single instanced draw
+static void record_draws(VkCommandBuffer command_buffer,
+                         uint32_t first,
+                         uint32_t count,
+                         uint32_t instance_count,
+                         bool draw_per_instance)
+{
+  const auto vertex_count = static_cast<uint32_t>(vertices.size());
+  if (draw_per_instance) {
+    for (uint32_t instance = first; instance < first + count; ++instance)
+      vkCmdDraw(command_buffer, vertex_count, 1, 0, instance);
+  } else {
+    vkCmdDraw(command_buffer, vertex_count, instance_count, 0, 0);
+  }
+}
 
-    std::cout << "joystick connected\n";
-  } else if (event == GLFW_DISCONNECTED) {
-    // The joystick was disconnected
+//! the image a frame renders into, render_pass is VK_NULL_HANDLE
+//! with dynamic rendering, which renders into image_view directly
+struct RenderTarget {
+  VkRenderPass render_pass;
+  VkFramebuffer framebuffer;
+  VkImage image;
+  VkImageView image_view;
+  VkFormat format;
+  VkImageLayout final_layout;
+};
 
-    std::cout << "joystick disconnected\n";
+static void transition_image_layout(VkCommandBuffer command_buffer,
+                                    VkImage image,
+                                    VkImageLayout old_layout,
+                                    VkImageLayout new_layout,
+                                    VkPipelineStageFlags2 src_stage,
+                                    VkAccessFlags2 src_access,
+                                    VkPipelineStageFlags2 dst_stage,
+                                    VkAccessFlags2 dst_access)
+{
+  VkImageMemoryBarrier2 barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+  barrier.srcStageMask = src_stage;
+  barrier.srcAccessMask = src_access;
+  barrier.dstStageMask = dst_stage;
+  barrier.dstAccessMask = dst_access;
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  VkDependencyInfo dependency_info{};
+  dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependency_info.imageMemoryBarrierCount = 1;
+  dependency_info.pImageMemoryBarriers = &barrier;
+  vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+}
+
+static void begin_rendering(VkCommandBuffer command_buffer,
+                            const RenderTarget& render_target,
+                            const VkExtent2D& actual_extent,
+                            bool secondary_command_buffers)
+{
+  const VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+  if (render_target.render_pass != VK_NULL_HANDLE) {
+    VkRenderPassBeginInfo render_pass_info{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_info.renderPass = render_target.render_pass;
+    render_pass_info.framebuffer = render_target.framebuffer;
+    render_pass_info.renderArea.offset = {0, 0};
+    render_pass_info.renderArea.extent = actual_extent;
+    render_pass_info.clearValueCount = 1;
+    render_pass_info.pClearValues = &clearColor;
+
+    vkCmdBeginRenderPass(command_buffer, &render_pass_info,
+                         secondary_command_buffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                                   : VK_SUBPASS_CONTENTS_INLINE);
+    return;
   }
 
-  std::cout.flush();
+  // the render pass did these transitions through initialLayout, the
+  // subpass layout and the external dependency
+  transition_image_layout(command_buffer, render_target.image,
+                          VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                          VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE,
+                          VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+
+  VkRenderingAttachmentInfo color_attachment{};
+  color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+  color_attachment.imageView = render_target.image_view;
+  color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  color_attachment.clearValue = clearColor;
+
+  VkRenderingInfo rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+  rendering_info.flags = secondary_command_buffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+  rendering_info.renderArea.offset = {0, 0};
+  rendering_info.renderArea.extent = actual_extent;
+  rendering_info.layerCount = 1;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachments = &color_attachment;
+
+  vkCmdBeginRendering(command_buffer, &rendering_info);
+}
+
+static void end_rendering(VkCommandBuffer command_buffer, const RenderTarget& render_target)
+{
+  if (render_target.render_pass != VK_NULL_HANDLE) {
+    vkCmdEndRenderPass(command_buffer);
+    return;
+  }
+
+  vkCmdEndRendering(command_buffer);
+
+  if (render_target.final_layout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
+    // presentation is ordered by the render finished semaphore
+    transition_image_layout(command_buffer, render_target.image,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, render_target.final_layout,
+                            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
+  }
 }
 
 static void record_command_buffer(std::remove_pointer_t<VkCommandBuffer> &command_buffer,
                                   std::remove_pointer_t<VkPipeline> &graphics_pipeline,
-                                  std::remove_pointer_t<VkRenderPass> &render_pass,
-                                  std::remove_pointer_t<VkFramebuffer> &swap_chain_framebuffer,
+                                  const FrameBindings &frame_bindings,
+                                  const RenderTarget &render_target,
                                   VkExtent2D &actual_extent,
-                                  VkBuffer vertex_buffer)
+                                  VkBuffer vertex_buffer,
+                                  VkBuffer instance_buffer,
+                                  uint32_t instance_count,
+                                  bool draw_per_instance,
+                                  ParallelRecorder* parallel_recorder,
+                                  GpuCulling* gpu_culling,
+                                  GpuTimer* gpu_timer,
+                                  uint32_t frame)
 {
+  PROFILE_ZONE("record command buffer");
   VkCommandBufferBeginInfo begin_info{};
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.flags = 0; // Optional
@@ -138,42 +752,42 @@ static void record_command_buffer(std::remove_pointer_t<VkCommandBuffer> &comman
     throw std::runtime_error("failed to begin recording command buffer!");
   }
 
-  VkRenderPassBeginInfo render_pass_info{};
-  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  render_pass_info.renderPass = &render_pass;
-  render_pass_info.framebuffer = &swap_chain_framebuffer;
-  render_pass_info.renderArea.offset = {0, 0};
-  render_pass_info.renderArea.extent = actual_extent;
-
-  VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-  render_pass_info.clearValueCount = 1;
-  render_pass_info.pClearValues = &clearColor;
+  if (gpu_timer != nullptr)
+    gpu_timer->begin(&command_buffer, frame);
+
+  if (gpu_culling != nullptr)
+    gpu_culling->cull(&command_buffer, frame, {-1.0f, -1.0f, 1.0f, 1.0f});
+
+  const uint32_t draw_count = draw_per_instance ? instance_count : 1;
+  if (parallel_recorder != nullptr) {
+    begin_rendering(&command_buffer, render_target, actual_extent, true);
+
+    const auto& secondary_command_buffers = parallel_recorder->record(
+      frame, render_target.render_pass, render_target.framebuffer, render_target.format, draw_count,
+      [&](VkCommandBuffer secondary_command_buffer, uint32_t first, uint32_t count) {
+        record_draw_state(secondary_command_buffer, &graphics_pipeline, frame_bindings, actual_extent,
+                          vertex_buffer, instance_buffer);
+        record_draws(secondary_command_buffer, first, count, instance_count, draw_per_instance);
+      });
+    vkCmdExecuteCommands(&command_buffer,
+                         static_cast<uint32_t>(secondary_command_buffers.size()),
+                         secondary_command_buffers.data());
+  } else {
+    begin_rendering(&command_buffer, render_target, actual_extent, false);
+
+    record_draw_state(&command_buffer, &graphics_pipeline, frame_bindings, actual_extent, vertex_buffer, instance_buffer);
+    if (gpu_culling != nullptr) {
+      gpu_culling->draw(&command_buffer, frame);
+    } else {
+      record_draws(&command_buffer, 0, draw_count, instance_count, draw_per_instance);
+    }
+  }
 
-  vkCmdBeginRenderPass(&command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+  end_rendering(&command_buffer, render_target);
 
-  vkCmdBindPipeline(&command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, &graphics_pipeline);
-  VkBuffer vertexBuffers[] = {vertex_buffer};
-  VkDeviceSize offsets[] = {0};
-  vkCmdBindVertexBuffers(&command_buffer, 0, 1, vertexBuffers, offsets);
+  if (gpu_timer != nullptr)
+    gpu_timer->end(&command_buffer, frame);
 
-  {
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(actual_extent.width);
-    viewport.height = static_cast<float>(actual_extent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(&command_buffer, 0, 1, &viewport);
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = actual_extent;
-    vkCmdSetScissor(&command_buffer, 0, 1, &scissor);
-    vkCmdDraw(&command_buffer, 3, 1, 0, 0);
-  }
-
-  vkCmdEndRenderPass(&command_buffer);
   if (vkEndCommandBuffer(&command_buffer) != VK_SUCCESS) {
     throw std::runtime_error("failed to record command buffer!");
   }
@@ -188,6 +802,50 @@ int main(int argc, char** argv)
     ("w,width", "window width", cxxopts::value<int>()->default_value("640"))
     ("x,height", "window height", cxxopts::value<int>()->default_value("480"))
     ("d,debug", "Enable debugging", cxxopts::value<bool>()->default_value("false"))
+    ("frames-in-flight", "number of frames the CPU may record ahead of the GPU",
+     cxxopts::value<uint32_t>()->default_value("2"))
+    ("headless", "render into offscreen images without creating a window",
+     cxxopts::value<bool>()->default_value("false"))
+    ("frames", "number of frames to render before exiting, 0 renders until closed",
+     cxxopts::value<uint64_t>()->default_value("0"))
+    ("instances", "draw the triangle N times with per-instance offset, scale and color, 0 disables instancing",
+     cxxopts::value<uint32_t>()->default_value("0"))
+    ("gpu-culling", "cull the instances in a compute shader and draw them with vkCmdDrawIndirectCount",
+     cxxopts::value<bool>()->default_value("false"))
+    ("draw-per-instance", "issue one draw call per instance instead of a single instanced draw",
+     cxxopts::value<bool>()->default_value("false"))
+    ("record-threads", "record the draw calls into secondary command buffers on N worker threads, 0 records inline",
+     cxxopts::value<uint32_t>()->default_value("0"))
+    ("prerecord", "record one command buffer per swap chain image once and resubmit it every frame",
+     cxxopts::value<bool>()->default_value("false"))
+    ("dynamic-rendering", "render with vkCmdBeginRendering instead of render passes and framebuffers",
+     cxxopts::value<bool>()->default_value("false"))
+    ("allocator", "GPU memory sub-allocation strategy: free-list or buddy",
+     cxxopts::value<std::string>()->default_value("free-list"))
+    ("shader-dir", "load .spv files from this directory instead of the shaders embedded in the executable",
+     cxxopts::value<std::string>())
+    ("pipeline-library", "build the graphics pipeline from separately compiled parts with VK_EXT_graphics_pipeline_library "
+     "if the device supports it",
+     cxxopts::value<bool>()->default_value("true"))
+    ("watch-shaders", "rebuild the graphics pipeline in the background whenever a shader in --shader-dir changes",
+     cxxopts::value<bool>()->default_value("false"))
+    ("pipeline-cache", "pipeline cache file, defaults to $XDG_CACHE_HOME or the executable directory",
+     cxxopts::value<std::string>())
+    ("present-mode", "immediate, mailbox, fifo or fifo-relaxed, falls back to fifo if the surface does not support it",
+     cxxopts::value<std::string>()->default_value("mailbox"))
+    ("max-fps", "limit the frame rate on the CPU, 0 renders as fast as the present mode allows",
+     cxxopts::value<double>()->default_value("0"))
+    ("pace-to-refresh", "with mailbox and no --max-fps, limit the frame rate to the refresh rate of the monitor "
+     "the window is on, immediate stays uncapped",
+     cxxopts::value<bool>()->default_value("true"))
+    ("present-wait", "wait until the frame submitted frames-in-flight frames earlier is displayed with "
+     "VK_KHR_present_wait if the device supports it",
+     cxxopts::value<bool>()->default_value("true"))
+    ("record-input", "record key and resize events into this file", cxxopts::value<std::string>())
+    ("replay-input", "replay the key and resize events of a recording", cxxopts::value<std::string>())
+    ("replay-fast", "replay the recording as fast as the frames render, every frame advances it by 1/60 s",
+     cxxopts::value<bool>()->default_value("false"))
+    ("trace", "write the profiled zones as a Chrome trace to this file on exit", cxxopts::value<std::string>())
     ("h,help", "Print usage");
   const auto parse_result = options.parse(argc, argv);
 
@@ -196,22 +854,126 @@ int main(int argc, char** argv)
     return 0;
   }
 
+  const uint32_t frames_in_flight = parse_result["frames-in-flight"].as<uint32_t>();
+  if (frames_in_flight == 0) {
+    std::cerr << "frames-in-flight must be at least 1\n";
+    return EXIT_FAILURE;
+  }
+
+  const bool headless = parse_result["headless"].as<bool>();
+  const uint64_t max_frames = parse_result["frames"].as<uint64_t>();
+  const std::optional<std::filesystem::path> shader_dir = parse_result.count("shader-dir")
+    ? std::optional<std::filesystem::path>{parse_result["shader-dir"].as<std::string>()}
+    : std::nullopt;
+  // the embedded shaders cannot change while running
+  const bool watch_shaders = parse_result["watch-shaders"].as<bool>();
+  if (watch_shaders && !shader_dir) {
+    std::cerr << "watch-shaders needs --shader-dir\n";
+    return EXIT_FAILURE;
+  }
+
+  const auto requested_present_mode = parse_present_mode(parse_result["present-mode"].as<std::string>());
+  if (!requested_present_mode) {
+    std::cerr << "present-mode must be immediate, mailbox, fifo or fifo-relaxed\n";
+    return EXIT_FAILURE;
+  }
+
+  const double max_fps = parse_result["max-fps"].as<double>();
+  if (max_fps < 0.0) {
+    std::cerr << "max-fps must not be negative\n";
+    return EXIT_FAILURE;
+  }
+  const bool pace_to_refresh = parse_result["pace-to-refresh"].as<bool>() && max_fps == 0.0;
+
+  if (parse_result.count("record-input") && parse_result.count("replay-input")) {
+    std::cerr << "record-input cannot be combined with --replay-input\n";
+    return EXIT_FAILURE;
+  }
+  const bool replay_fast = parse_result["replay-fast"].as<bool>();
+
+  const std::optional<std::filesystem::path> trace_path = parse_result.count("trace")
+    ? std::optional<std::filesystem::path>{parse_result["trace"].as<std::string>()}
+    : std::nullopt;
+#if !defined(PROFILING)
+  if (trace_path) {
+    std::cerr << "trace needs a build configured with -DPROFILING=ON\n";
+    return EXIT_FAILURE;
+  }
+#endif
+  // zones are only kept for a trace someone asked for
+  profiler::set_enabled(trace_path.has_value());
+  // written on failures as well, those are the runs most worth a look
+  const auto write_trace = [&trace_path]() {
+    if (!trace_path)
+      return;
+
+    try {
+      profiler::write_chrome_trace(*trace_path);
+      if (const uint64_t overwritten = profiler::overwritten_zones(); overwritten != 0)
+        std::cout << "trace holds the last zones only, " << overwritten << " older zones were overwritten\n";
+    } catch (const std::exception& e) {
+      std::cerr << "writing trace failed: " << e.what() << '\n';
+    }
+  };
+
+  const uint32_t instance_count = parse_result["instances"].as<uint32_t>();
+  const bool gpu_culling_enabled = parse_result["gpu-culling"].as<bool>();
+  if (gpu_culling_enabled && instance_count == 0) {
+    std::cerr << "gpu-culling needs --instances\n";
+    return EXIT_FAILURE;
+  }
+
+  const bool draw_per_instance = parse_result["draw-per-instance"].as<bool>();
+  const uint32_t record_threads = parse_result["record-threads"].as<uint32_t>();
+  if (gpu_culling_enabled && (draw_per_instance || record_threads > 0)) {
+    std::cerr << "gpu-culling generates its draws on the GPU and cannot be combined with "
+                 "--draw-per-instance or --record-threads\n";
+    return EXIT_FAILURE;
+  }
+
+  // per frame in flight resources such as the culling buffers cannot
+  // be baked into command buffers that are owned by swap chain images
+  const bool prerecord = parse_result["prerecord"].as<bool>();
+  if (prerecord && (gpu_culling_enabled || record_threads > 0)) {
+    std::cerr << "prerecord cannot be combined with --gpu-culling or --record-threads\n";
+    return EXIT_FAILURE;
+  }
+
+  AllocationStrategy allocation_strategy;
+  if (parse_result["allocator"].as<std::string>() == "free-list") {
+    allocation_strategy = AllocationStrategy::FREE_LIST;
+  } else if (parse_result["allocator"].as<std::string>() == "buddy") {
+    allocation_strategy = AllocationStrategy::BUDDY;
+  } else {
+    std::cerr << "unknown allocator \"" << parse_result["allocator"].as<std::string>() << "\"\n";
+    return EXIT_FAILURE;
+  }
+
   std::cout << "version: " << get_instance_version() << '\n';
 
   try {
+    PROFILE_THREAD_NAME("main");
     glfwSetErrorCallback(error_callback);
-    GraphicsContext context;
-    context.set_window_floating_hint(true);
-    glfwSetJoystickCallback(joystick_callback);
-
-    if (!context.vulkan_supported()) {
-      throw std::runtime_error("Vulkan is not supported");
+    // GLFW needs a display server, a headless run must not touch it
+    std::optional<GraphicsContext> context;
+    uint32_t required_extensions_count = 0;
+    const char** required_extensions = nullptr;
+    if (headless) {
+      std::signal(SIGINT, signal_handler);
     } else {
-      std::cout << "Vulkan support is present\n";
-    }
+      context.emplace();
+      context->set_window_floating_hint(true);
+      context->set_window_resizable_hint(true);
+      glfwSetJoystickCallback(joystick_callback);
 
-    uint32_t required_extensions_count;
-    const char** required_extensions = glfwGetRequiredInstanceExtensions(&required_extensions_count);
+      if (!context->vulkan_supported()) {
+        throw std::runtime_error("Vulkan is not supported");
+      } else {
+        std::cout << "Vulkan support is present\n";
+      }
+
+      required_extensions = glfwGetRequiredInstanceExtensions(&required_extensions_count);
+    }
 
     std::cout << "required extensions:\n";
     if (required_extensions != nullptr) {
@@ -250,7 +1012,7 @@ int main(int argc, char** argv)
                                                [](auto& layer) {
                                                  return strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0;
                                                });
-    if (validation_layer_found == available_layers.end())
+    if (parse_result["debug"].as<bool>() && validation_layer_found == available_layers.end())
       throw std::runtime_error("validation layer not available");
 
     VkApplicationInfo app_info = {};
@@ -280,6 +1042,7 @@ int main(int argc, char** argv)
     };
 
     {
+      PROFILE_ZONE("create instance");
       VkInstance temp_instance;
       if (vkCreateInstance(&create_info, nullptr, &temp_instance) != VK_SUCCESS) {
         throw std::runtime_error("Vulkan instance creation failed");
@@ -315,27 +1078,180 @@ int main(int argc, char** argv)
       ++index;
     }
 
+    // prefer a transfer-only family, its queue usually maps to a DMA
+    // engine which copies in parallel to rendering
+    uint32_t transfer_queue_family_index = queue_family_index.value();
+    for (uint32_t family = 0; family < queue_family_count; ++family) {
+      const VkQueueFlags flags = queue_families[family].queueFlags;
+      if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+        transfer_queue_family_index = family;
+        break;
+      }
+    }
+    std::cout << "transfer queue family: " << transfer_queue_family_index << '\n';
+
+    VkPhysicalDeviceProperties device_properties;
+    vkGetPhysicalDeviceProperties(physical_devices[0], &device_properties);
+
     // https://vulkan-tutorial.com/en/Drawing_a_triangle/Setup/Logical_device_and_queues
-    VkDeviceQueueCreateInfo queue_create_info{};
-    queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queue_create_info.queueFamilyIndex = queue_family_index.value();
-    queue_create_info.queueCount = 1;
+    std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
     const float queue_priority = 1.0f;
-    queue_create_info.pQueuePriorities = &queue_priority;
+    for (const uint32_t family : std::set<uint32_t>{queue_family_index.value(), transfer_queue_family_index}) {
+      VkDeviceQueueCreateInfo queue_create_info{};
+      queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+      queue_create_info.queueFamilyIndex = family;
+      queue_create_info.queueCount = 1;
+      queue_create_info.pQueuePriorities = &queue_priority;
+      queue_create_infos.push_back(queue_create_info);
+    }
+
+    // frame pacing relies on timeline semaphores and vkQueueSubmit2,
+    // both core in Vulkan 1.3, as is dynamic rendering, so render
+    // passes are a choice and no fallback
+    if (device_properties.apiVersion < VK_API_VERSION_1_3) {
+      throw std::runtime_error("device does not support Vulkan 1.3!");
+    }
+
+    std::set<std::string> available_device_extensions;
+    {
+      uint32_t extension_count;
+      vkEnumerateDeviceExtensionProperties(physical_devices[0], nullptr, &extension_count, nullptr);
+
+      std::vector<VkExtensionProperties> available_extensions(extension_count);
+      vkEnumerateDeviceExtensionProperties(physical_devices[0], nullptr, &extension_count, available_extensions.data());
+
+      for (const auto& extension: available_extensions) {
+        available_device_extensions.insert(extension.extensionName);
+      }
+    }
+
+    // the feature structure of an extension may only be chained if the
+    // device has the extension
+    const bool pipeline_library_available =
+      available_device_extensions.count(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) != 0 &&
+      available_device_extensions.count(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) != 0;
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supported_pipeline_library_features{};
+    supported_pipeline_library_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    VkPhysicalDeviceVulkan13Features supported_vulkan13_features{};
+    supported_vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    if (pipeline_library_available)
+      supported_vulkan13_features.pNext = &supported_pipeline_library_features;
+    VkPhysicalDeviceVulkan12Features supported_vulkan12_features{};
+    supported_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supported_vulkan12_features.pNext = &supported_vulkan13_features;
+    // present wait needs present ids to refer to a present
+    const bool present_wait_available =
+      !headless &&
+      available_device_extensions.count(VK_KHR_PRESENT_ID_EXTENSION_NAME) != 0 &&
+      available_device_extensions.count(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) != 0;
+    VkPhysicalDevicePresentWaitFeaturesKHR supported_present_wait_features{};
+    supported_present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    supported_present_wait_features.pNext = &supported_vulkan12_features;
+    VkPhysicalDevicePresentIdFeaturesKHR supported_present_id_features{};
+    supported_present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    supported_present_id_features.pNext = &supported_present_wait_features;
+    VkPhysicalDeviceFeatures2 supported_features{};
+    supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported_features.pNext = present_wait_available
+      ? static_cast<void*>(&supported_present_id_features)
+      : static_cast<void*>(&supported_vulkan12_features);
+    vkGetPhysicalDeviceFeatures2(physical_devices[0], &supported_features);
+
+    if (!supported_vulkan12_features.timelineSemaphore || !supported_vulkan13_features.synchronization2) {
+      throw std::runtime_error("device does not support timeline semaphores and synchronization2!");
+    }
 
     VkPhysicalDeviceFeatures device_features{};
+    VkPhysicalDeviceVulkan13Features vulkan13_features{};
+    vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    vulkan13_features.synchronization2 = VK_TRUE;
+    VkPhysicalDeviceVulkan12Features vulkan12_features{};
+    vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12_features.pNext = &vulkan13_features;
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+
+    if (gpu_culling_enabled) {
+      if (!supported_features.features.drawIndirectFirstInstance || !supported_vulkan12_features.drawIndirectCount) {
+        throw std::runtime_error("device does not support indirect draws with a count buffer!");
+      }
+      // every instance may survive culling and become a draw
+      if (instance_count > device_properties.limits.maxDrawIndirectCount) {
+        throw std::runtime_error("failed to cull " + std::to_string(instance_count) +
+                                 " instances, the device draws at most " +
+                                 std::to_string(device_properties.limits.maxDrawIndirectCount) +
+                                 " indirect draws at once!");
+      }
+      if (!(queue_families[queue_family_index.value()].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+        throw std::runtime_error("graphics queue does not support compute!");
+      }
+
+      // the culling shader selects the instance through firstInstance
+      device_features.drawIndirectFirstInstance = VK_TRUE;
+      vulkan12_features.drawIndirectCount = VK_TRUE;
+    }
+
+    const bool dynamic_rendering = parse_result["dynamic-rendering"].as<bool>();
+    if (dynamic_rendering)
+      vulkan13_features.dynamicRendering = VK_TRUE;
+    std::cout << "rendering with " << (dynamic_rendering ? "dynamic rendering" : "render passes") << '\n';
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipeline_library_features{};
+    pipeline_library_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    bool pipeline_library = parse_result["pipeline-library"].as<bool>();
+    if (pipeline_library) {
+      if (pipeline_library_available && supported_pipeline_library_features.graphicsPipelineLibrary) {
+        pipeline_library_features.graphicsPipelineLibrary = VK_TRUE;
+        vulkan13_features.pNext = &pipeline_library_features;
+      } else {
+        std::cout << "device does not support graphics pipeline libraries, building complete pipelines\n";
+        pipeline_library = false;
+      }
+    }
+
+    // paces the CPU against the frames actually reaching the display
+    // instead of against the swap chain handing out images
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    present_wait_features.pNext = &vulkan12_features;
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    present_id_features.pNext = &present_wait_features;
+    bool present_wait = parse_result["present-wait"].as<bool>() && !headless;
+    if (present_wait) {
+      if (present_wait_available && supported_present_id_features.presentId &&
+          supported_present_wait_features.presentWait) {
+        present_id_features.presentId = VK_TRUE;
+        present_wait_features.presentWait = VK_TRUE;
+      } else {
+        std::cout << "device does not support present wait, pacing by the swap chain only\n";
+        present_wait = false;
+      }
+    }
 
     std::unique_ptr<std::remove_pointer_t<VkDevice>, void (*)(VkDevice)>
       device{nullptr, [](VkDevice device) { vkDestroyDevice(device, nullptr); }};
     {
-      const std::vector<const char*> device_extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-      };
+      PROFILE_ZONE("create device");
+      std::vector<const char*> device_extensions;
+      if (!headless) {
+        device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+      }
+      if (pipeline_library) {
+        device_extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        device_extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+      }
+      if (present_wait) {
+        device_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        device_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+      }
 
       VkDeviceCreateInfo create_info{};
       create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-      create_info.pQueueCreateInfos = &queue_create_info;
-      create_info.queueCreateInfoCount = 1;
+      create_info.pNext = present_wait
+        ? static_cast<void*>(&present_id_features)
+        : static_cast<void*>(&vulkan12_features);
+      create_info.pQueueCreateInfos = queue_create_infos.data();
+      create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
       create_info.pEnabledFeatures = &device_features;
       create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
       create_info.ppEnabledExtensionNames = device_extensions.data();
@@ -351,23 +1267,53 @@ int main(int argc, char** argv)
 
     VkQueue graphics_queue;
     vkGetDeviceQueue(device.get(), queue_family_index.value(), 0, &graphics_queue);
+    VkQueue transfer_queue;
+    vkGetDeviceQueue(device.get(), transfer_queue_family_index, 0, &transfer_queue);
+
+    GpuAllocator allocator{device.get(), physical_devices[0], allocation_strategy};
+
+    // the loader only exports core and window system entry points
+    PFN_vkWaitForPresentKHR wait_for_present = nullptr;
+    if (present_wait) {
+      wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+        vkGetDeviceProcAddr(device.get(), "vkWaitForPresentKHR"));
+      if (wait_for_present == nullptr) {
+        throw std::runtime_error("failed to load vkWaitForPresentKHR!");
+      }
+    }
 
-    Window window{parse_result["width"].as<int>(), parse_result["height"].as<int>(), "Vulkan"};
+    std::optional<Window> window;
 
     // https://vulkan-tutorial.com/en/Drawing_a_triangle/Presentation/Window_surface
     std::unique_ptr<std::remove_pointer_t<VkSurfaceKHR>, std::function<void(VkSurfaceKHR)>> surface{
-      window.create_window_surface(instance.get()),
+      nullptr,
       [&instance](VkSurfaceKHR surface) { vkDestroySurfaceKHR(instance.get(), surface, nullptr); }
     };
 
-    VkBool32 present_support = VK_FALSE;
-    vkGetPhysicalDeviceSurfaceSupportKHR(physical_devices[0], queue_family_index.value(), surface.get(), &present_support);
-    std::cout << std::boolalpha << "present_support: " << present_support << '\n';
+    if (!headless) {
+      window.emplace(parse_result["width"].as<int>(), parse_result["height"].as<int>(), "Vulkan");
+      surface.reset(window->create_window_surface(instance.get()));
+
+      VkBool32 present_support = VK_FALSE;
+      vkGetPhysicalDeviceSurfaceSupportKHR(physical_devices[0], queue_family_index.value(), surface.get(), &present_support);
+      std::cout << std::boolalpha << "present_support: " << present_support << '\n';
+
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+      window->set_key_callback(key_callback);
+      window->set_framebuffer_size_callback(framebuffer_size_callback);
+    }
 
-    window.set_key_callback(key_callback);
+    // monitors can only be queried on the main thread, which keeps the
+    // refresh period of the monitor the window is on up to date
+    std::optional<MonitorDatabase> monitor_database;
+    std::atomic<double> refresh_period{0.0};
+    if (window) {
+      monitor_database.emplace();
+      refresh_period = monitor_database->refresh_period(window->raw_glfw_window());
+      std::cout << "refresh period: " << refresh_period.load() * 1000.0 << " ms\n";
+    }
 
     // https://vulkan-tutorial.com/en/Drawing_a_triangle/Presentation/Swap_chain
     std::unique_ptr<std::remove_pointer_t<VkSwapchainKHR>, std::function<void(VkSwapchainKHR)>>
@@ -382,27 +1328,26 @@ int main(int argc, char** argv)
       std::vector<VkPresentModeKHR> present_modes;
     };
     SwapChainSupportDetails details;
+    // only the main thread may ask GLFW, the render thread learns about
+    // changes through resize events
+    std::pair<int, int> framebuffer_size{0, 0};
+    if (window)
+      framebuffer_size = window->framebuffer_size();
+    bool framebuffer_resized = false;
     VkExtent2D actual_extent{};
-    {
-      uint32_t extension_count;
-      vkEnumerateDeviceExtensionProperties(physical_devices[0], nullptr, &extension_count, nullptr);
-
-      std::vector<VkExtensionProperties> available_extensions(extension_count);
-      vkEnumerateDeviceExtensionProperties(physical_devices[0], nullptr, &extension_count, available_extensions.data());
-
-      std::set<std::string> available_extension_set;
-      for (const auto& extension: available_extensions) {
-        available_extension_set.insert(extension.extensionName);
-      }
-
-      for (const auto& extension: available_extension_set) {
-        std::cout << '\t' << extension << '\n';
-      }
-
+    const VkFormat color_format = VK_FORMAT_B8G8R8A8_SRGB;
+    VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    // the refresh period the image count of the swap chain was chosen for
+    double swap_chain_refresh_period = 0.0;
+
+    // creates a swap chain matching the current framebuffer size, an
+    // existing swap chain is passed as oldSwapchain and destroyed
+    // once its successor exists
+    const auto create_swap_chain = [&]() {
+      PROFILE_ZONE("create swap chain");
       if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_devices[0], surface.get(), &details.capabilities) != VK_SUCCESS)
         throw std::runtime_error("querying physical device surface capabilities");
-      int window_width, window_height;
-      std::tie(window_width, window_height) = window.framebuffer_size();
+      const auto [window_width, window_height] = framebuffer_size;
       std::cout << "currentExtent.height: " << details.capabilities.currentExtent.height <<
         " currentExtent.width: " << details.capabilities.currentExtent.width <<
         " window_height: " << window_height << " window width: " << window_width <<
@@ -415,6 +1360,48 @@ int main(int argc, char** argv)
                                         details.capabilities.minImageExtent.height,
                                         details.capabilities.maxImageExtent.height);
 
+      swap_chain_refresh_period = refresh_period;
+      const uint32_t image_count = swap_chain_image_count(details.capabilities, frames_in_flight,
+                                                          swap_chain_refresh_period);
+      std::cout << "swap chain image count: " << image_count << '\n';
+
+      VkSwapchainCreateInfoKHR create_info{};
+      create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+      create_info.surface = surface.get();
+      create_info.minImageCount = image_count;
+      create_info.imageFormat = color_format;
+      create_info.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+      create_info.imageExtent = actual_extent;
+      create_info.imageArrayLayers = 1;
+      create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+      if (details.capabilities.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+        create_info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+      else
+        throw std::runtime_error("VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR not supported");
+      if (details.capabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
+        create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+      else
+        throw std::runtime_error("VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR not supported");
+      create_info.clipped = VK_TRUE;
+      create_info.presentMode = present_mode;
+      create_info.oldSwapchain = swap_chain.get();
+
+      VkSwapchainKHR temp_swap_chain;
+      if (vkCreateSwapchainKHR(device.get(), &create_info, nullptr, &temp_swap_chain) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create swap chain!");
+      }
+
+      swap_chain.reset(temp_swap_chain);
+    };
+
+    if (headless) {
+      actual_extent.width = static_cast<uint32_t>(parse_result["width"].as<int>());
+      actual_extent.height = static_cast<uint32_t>(parse_result["height"].as<int>());
+    } else {
+      for (const auto& extension: available_device_extensions) {
+        std::cout << '\t' << extension << '\n';
+      }
+
       uint32_t format_count;
       vkGetPhysicalDeviceSurfaceFormatsKHR(physical_devices[0], surface.get(), &format_count, nullptr);
 
@@ -451,55 +1438,71 @@ int main(int argc, char** argv)
         std::cout << "present mode: " << vk::to_string(o) << '\n';
       }
 
-      const uint32_t image_count = details.capabilities.minImageCount + 1;
-      assert(image_count <= details.capabilities.maxImageCount);
-
-      VkSwapchainCreateInfoKHR create_info{};
-      create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-      create_info.surface = surface.get();
-      create_info.minImageCount = image_count;
-      create_info.imageFormat = VK_FORMAT_B8G8R8A8_SRGB;
-      create_info.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
-      create_info.imageExtent = actual_extent;
-      create_info.imageArrayLayers = 1;
-      create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-      if (details.capabilities.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
-        create_info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
-      else
-        throw std::runtime_error("VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR not supported");
-      if (details.capabilities.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
-        create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-      else
-        throw std::runtime_error("VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR not supported");
-      create_info.clipped = VK_TRUE;
+      // FIFO is the only mode every surface has to support
       if (std::find(std::begin(details.present_modes), std::end(details.present_modes),
-                    VK_PRESENT_MODE_MAILBOX_KHR) != details.present_modes.end()) {
-        std::cout << "use VK_PRESENT_MODE_MAILBOX_KHR\n";
-        create_info.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+                    *requested_present_mode) != details.present_modes.end()) {
+        present_mode = *requested_present_mode;
       } else {
-        std::cout << "use VK_PRESENT_MODE_FIFO_KHR\n";
-        create_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        std::cout << "present mode " << vk::to_string(static_cast<vk::PresentModeKHR>(*requested_present_mode))
+                  << " is not supported by the surface, falling back to fifo\n";
+        present_mode = VK_PRESENT_MODE_FIFO_KHR;
       }
-      create_info.oldSwapchain = VK_NULL_HANDLE;
+      std::cout << "use present mode: " << vk::to_string(static_cast<vk::PresentModeKHR>(present_mode)) << '\n';
 
+      create_swap_chain();
+    }
 
-      {
-        VkSwapchainKHR temp_swap_chain;
-        if (vkCreateSwapchainKHR(device.get(), &create_info, nullptr, &temp_swap_chain) != VK_SUCCESS) {
-          throw std::runtime_error("failed to create swap chain!");
+    // headless runs render into these instead of swap chain images
+    std::vector<std::unique_ptr<std::remove_pointer_t<VkImage>, std::function<void(VkImage)>>>
+      offscreen_images;
+
+    std::vector<VkImage> swap_chain_images;
+    if (headless) {
+      for (uint32_t frame = 0; frame < frames_in_flight; ++frame) {
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = color_format;
+        image_info.extent = {actual_extent.width, actual_extent.height, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkImage temp_image;
+        if (vkCreateImage(device.get(), &image_info, nullptr, &temp_image) != VK_SUCCESS) {
+          throw std::runtime_error("failed to create offscreen image!");
+        }
+
+        GpuAllocation image_allocation;
+        try {
+          image_allocation = allocator.allocate_image_memory(temp_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        } catch (...) {
+          vkDestroyImage(device.get(), temp_image, nullptr);
+          throw;
         }
 
-        swap_chain.reset(temp_swap_chain);
+        offscreen_images.emplace_back(temp_image, [&device, &allocator, image_allocation](VkImage image) {
+          vkDestroyImage(device.get(), image, nullptr);
+          allocator.free(image_allocation);
+        });
+        swap_chain_images.push_back(temp_image);
       }
     }
 
     std::vector<std::unique_ptr<std::remove_pointer_t<VkImageView>, std::function<void(VkImageView)>>>
       swap_chain_image_views;
-    {
-      // Retrieving the swap chain images
+    // a recreated swap chain may have a different number of images,
+    // that's why they are retrieved again every time
+    const auto create_image_views = [&]() {
+      swap_chain_image_views.clear();
+
+      if (!headless) {
+        // Retrieving the swap chain images
 
-      std::vector<VkImage> swap_chain_images;
-      {
         uint32_t image_count;
 
         vkGetSwapchainImagesKHR(device.get(), swap_chain.get(), &image_count, nullptr);
@@ -514,7 +1517,7 @@ int main(int argc, char** argv)
         create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         create_info.image = swap_chain_image;
         create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        create_info.format = details.formats[1].format; // should be B8G8R8A8Srgb : SrgbNonlinear
+        create_info.format = color_format;
         create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
         create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
         create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -534,7 +1537,8 @@ int main(int argc, char** argv)
           vkDestroyImageView(device.get(), image_view, nullptr);
         });
       }
-    }
+    };
+    create_image_views();
 
     std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>>
       vert_shader_module{nullptr, [&device](VkShaderModule shader_module) {
@@ -544,76 +1548,11 @@ int main(int argc, char** argv)
       frag_shader_module{nullptr, [&device](VkShaderModule shader_module) {
         vkDestroyShaderModule(device.get(), shader_module, nullptr);
       }};
-    VkPipelineShaderStageCreateInfo shader_stages[2]{};
-    {
-      // https://vulkan-tutorial.com/en/Drawing_a_triangle/Graphics_pipeline_basics/Shader_modules
-      {
-        std::ifstream file(executable_dir / "vert.spv", std::ios::ate | std::ios::binary);
-        if (!file.is_open()) {
-          std::ostringstream oss;
-          oss << "failed to open file \"" << (executable_dir / "vert.spv") << '\"';
-          throw std::runtime_error(oss.str());
-        }
-        const size_t file_size = (size_t) file.tellg();
-        std::vector<char, AlignedAllocator<char, uint32_t>> code(file_size);
-        file.seekg(0);
-        file.read(code.data(), static_cast<std::streamsize>(file_size));
-
-        VkShaderModuleCreateInfo create_info{};
-        create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        create_info.codeSize = code.size();
-        create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-        VkShaderModule shader_module;
-        if (vkCreateShaderModule(device.get(), &create_info, nullptr, &shader_module) != VK_SUCCESS) {
-          throw std::runtime_error("failed to create shader module!");
-        }
-
-        vert_shader_module.reset(shader_module);
-      }
-
-      {
-        std::ifstream file(executable_dir / "frag.spv", std::ios::ate | std::ios::binary);
-        if (!file.is_open()) {
-          std::ostringstream oss;
-          oss << "failed to open file \"" << (executable_dir / "frag.spv") << '\"';
-          throw std::runtime_error(oss.str());
-        }
-        const size_t file_size = (size_t) file.tellg();
-        std::vector<char, AlignedAllocator<char, uint32_t>> code(file_size);
-        file.seekg(0);
-        file.read(code.data(), static_cast<std::streamsize>(file_size));
-
-        VkShaderModuleCreateInfo create_info{};
-        create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        create_info.codeSize = code.size();
-        // TODO it is unclear whether vkCreateShaderModule copies the
-        // code or assumes that the vector lives long enough
-        create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-        VkShaderModule shader_module;
-        if (vkCreateShaderModule(device.get(), &create_info, nullptr, &shader_module) != VK_SUCCESS) {
-          throw std::runtime_error("failed to create shader module!");
-        }
-
-        frag_shader_module.reset(shader_module);
-      }
-
-      VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
-      vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      vert_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-      vert_shader_stage_info.module = vert_shader_module.get();
-      vert_shader_stage_info.pName = "main";
-
-      VkPipelineShaderStageCreateInfo frag_shader_stage_info{};
-      frag_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-      frag_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-      frag_shader_stage_info.module = frag_shader_module.get();
-      frag_shader_stage_info.pName = "main";
-
-      shader_stages[0] = vert_shader_stage_info;
-      shader_stages[1] = frag_shader_stage_info;
-    }
+    const std::string vert_shader_name = instance_count > 0 ? "vert_instanced.spv" : "vert.spv";
+    const std::string frag_shader_name = "frag.spv";
+    // https://vulkan-tutorial.com/en/Drawing_a_triangle/Graphics_pipeline_basics/Shader_modules
+    vert_shader_module.reset(load_shader_module(device.get(), shader_dir, vert_shader_name));
+    frag_shader_module.reset(load_shader_module(device.get(), shader_dir, frag_shader_name));
 
     std::unique_ptr<std::remove_pointer_t<VkRenderPass>,
                     std::function<void(VkRenderPass)>> render_pass{
@@ -622,6 +1561,12 @@ int main(int argc, char** argv)
         vkDestroyRenderPass(device.get(), render_pass, nullptr);
       }
     };
+    // per frame shader data lives in one persistently mapped buffer,
+    // each frame binds its own range with a dynamic offset
+    UniformRing uniform_ring{device.get(), allocator, 64 * 1024,
+                             device_properties.limits.minUniformBufferOffsetAlignment,
+                             sizeof(FrameUniforms), VK_SHADER_STAGE_VERTEX_BIT};
+
     std::unique_ptr<std::remove_pointer_t<VkPipelineLayout>,
                     std::function<void(VkPipelineLayout)>> pipeline_layout{
       nullptr,
@@ -629,22 +1574,30 @@ int main(int argc, char** argv)
         vkDestroyPipelineLayout(device.get(), pipeline_layout, nullptr);
       }
     };
-    std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>> graphics_pipeline{
-      nullptr,
-      [&device](VkPipeline graphics_pipeline) {
-        vkDestroyPipeline(device.get(), graphics_pipeline, nullptr);
-      }
-    };
+    const std::filesystem::path pipeline_cache_path = parse_result.count("pipeline-cache")
+      ? std::filesystem::path{parse_result["pipeline-cache"].as<std::string>()}
+      : default_pipeline_cache_path(executable_dir);
+    PipelineCache pipeline_cache{device.get(), device_properties, pipeline_cache_path};
+    std::cout << "pipeline cache " << pipeline_cache_path
+              << (pipeline_cache.loaded_from_file() ? " loaded\n" : " is empty\n");
+
     {
       // https://vulkan-tutorial.com/Drawing_a_triangle/Graphics_pipeline_basics/Render_passes
 
       {
+        const VkDescriptorSetLayout set_layout = uniform_ring.descriptor_set_layout();
+
+        VkPushConstantRange push_constant_range{};
+        push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(DrawConstants);
+
         VkPipelineLayoutCreateInfo pipeline_layout_info{};
         pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_info.setLayoutCount = 0; // Optional
-        pipeline_layout_info.pSetLayouts = nullptr; // Optional
-        pipeline_layout_info.pushConstantRangeCount = 0; // Optional
-        pipeline_layout_info.pPushConstantRanges = nullptr; // Optional
+        pipeline_layout_info.setLayoutCount = 1;
+        pipeline_layout_info.pSetLayouts = &set_layout;
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges = &push_constant_range;
 
         VkPipelineLayout temp_pipeline_layout;
         if (vkCreatePipelineLayout(device.get(), &pipeline_layout_info, nullptr, &temp_pipeline_layout) != VK_SUCCESS) {
@@ -655,14 +1608,15 @@ int main(int argc, char** argv)
       }
 
       VkAttachmentDescription color_attachment{};
-      color_attachment.format = details.formats[1].format;
+      color_attachment.format = color_format;
       color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
       color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
       color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
       color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
       color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
       color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+      // PRESENT_SRC_KHR requires VK_KHR_swapchain
+      color_attachment.finalLayout = headless ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
       VkAttachmentReference color_attachment_ref{};
       color_attachment_ref.attachment = 0;
@@ -673,7 +1627,7 @@ int main(int argc, char** argv)
       subpass.colorAttachmentCount = 1;
       subpass.pColorAttachments = &color_attachment_ref;
 
-      {
+      if (!dynamic_rendering) {
         VkSubpassDependency dependency{};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.dstSubpass = 0;
@@ -699,145 +1653,109 @@ int main(int argc, char** argv)
         render_pass.reset(temp_render_pass);
       }
 
-      std::vector<VkDynamicState> dynamic_states{
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-      };
-
-      VkPipelineDynamicStateCreateInfo dynamic_state{};
-      dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-      dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
-      dynamic_state.pDynamicStates = dynamic_states.data();
+    }
 
-      VkPipelineVertexInputStateCreateInfo vertex_input_info{};
-      vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-#if 0
-      vertex_input_info.vertexBindingDescriptionCount = 0;
-      vertex_input_info.pVertexBindingDescriptions = nullptr; // Optional
-      vertex_input_info.vertexAttributeDescriptionCount = 0;
-      vertex_input_info.pVertexAttributeDescriptions = nullptr; // Optional
-#endif
+    const auto pipeline_deleter = [&device](VkPipeline pipeline) {
+      vkDestroyPipeline(device.get(), pipeline, nullptr);
+    };
+    const auto create_pipeline_part = [&](VkGraphicsPipelineLibraryFlagsEXT library_parts, const PipelineState& state) {
+      PROFILE_ZONE("create pipeline part");
+      return create_graphics_pipeline(device.get(), pipeline_cache.get(), pipeline_layout.get(), state, library_parts);
+    };
 
-      auto bindingDescription = Vertex::getBindingDescription();
-      auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-      vertex_input_info.vertexBindingDescriptionCount = 1;
-      vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-      vertex_input_info.pVertexBindingDescriptions = &bindingDescription;
-      vertex_input_info.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-      VkPipelineInputAssemblyStateCreateInfo input_assembly{};
-      input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-      input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-      input_assembly.primitiveRestartEnable = VK_FALSE;
-
-      VkViewport viewport{};
-      viewport.x = 0.0f;
-      viewport.y = 0.0f;
-      viewport.width = (float) actual_extent.width;
-      viewport.height = (float) actual_extent.height;
-      viewport.minDepth = 0.0f;
-      viewport.maxDepth = 1.0f;
-
-      VkRect2D scissor{};
-      scissor.offset = {0, 0};
-      scissor.extent = actual_extent;
-
-      VkPipelineViewportStateCreateInfo viewport_state{};
-      viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-      viewport_state.viewportCount = 1;
-      viewport_state.pViewports = &viewport;
-      viewport_state.scissorCount = 1;
-      viewport_state.pScissors = &scissor;
-
-      VkPipelineRasterizationStateCreateInfo rasterizer{};
-      rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-      rasterizer.depthClampEnable = VK_FALSE;
-      rasterizer.rasterizerDiscardEnable = VK_FALSE;
-      rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-      rasterizer.lineWidth = 1.0f;
-      rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-      rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-      rasterizer.depthBiasEnable = VK_FALSE;
-      rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-      rasterizer.depthBiasClamp = 0.0f; // Optional
-      rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-      VkPipelineMultisampleStateCreateInfo multisampling{};
-      multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-      multisampling.sampleShadingEnable = VK_FALSE;
-      multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-      multisampling.minSampleShading = 1.0f; // Optional
-      multisampling.pSampleMask = nullptr; // Optional
-      multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-      multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-      VkPipelineColorBlendAttachmentState color_blend_attachment{};
-      color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-      color_blend_attachment.blendEnable = VK_FALSE;
-      color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-      color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-      color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-      color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-      color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-      color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
-      color_blend_attachment.blendEnable = VK_TRUE;
-      color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-      color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-      color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-      color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-      color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-      color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-      VkPipelineColorBlendStateCreateInfo color_blending{};
-      color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-      color_blending.logicOpEnable = VK_FALSE;
-      color_blending.logicOp = VK_LOGIC_OP_COPY; // Optional
-      color_blending.attachmentCount = 1;
-      color_blending.pAttachments = &color_blend_attachment;
-      color_blending.blendConstants[0] = 0.0f; // Optional
-      color_blending.blendConstants[1] = 0.0f; // Optional
-      color_blending.blendConstants[2] = 0.0f; // Optional
-      color_blending.blendConstants[3] = 0.0f; // Optional
+    // the interface libraries only depend on part of the state and
+    // are shared by all variants which agree on it
+    PipelineVariantCache vertex_input_libraries{device.get(), [&](const PipelineState& state) {
+      return create_pipeline_part(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, state);
+    }};
+    PipelineVariantCache fragment_output_libraries{device.get(), [&](const PipelineState& state) {
+      return create_pipeline_part(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, state);
+    }};
+    const auto vertex_input_state = [](const PipelineState& state) {
+      PipelineState key;
+      key.instanced = state.instanced;
+      return key;
+    };
+    const auto fragment_output_state = [](const PipelineState& state) {
+      PipelineState key = state;
+      key.vert_shader_module = VK_NULL_HANDLE;
+      key.frag_shader_module = VK_NULL_HANDLE;
+      key.instanced = false;
+      key.polygon_mode = VK_POLYGON_MODE_FILL;
+      return key;
+    };
 
-      {
-        VkGraphicsPipelineCreateInfo pipeline_info{};
-        pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipeline_info.stageCount = sizeof(shader_stages) / sizeof(VkPipelineShaderStageCreateInfo);
-        pipeline_info.pStages = shader_stages;
-        pipeline_info.pVertexInputState = &vertex_input_info;
-        pipeline_info.pInputAssemblyState = &input_assembly;
-        pipeline_info.pViewportState = &viewport_state;
-        pipeline_info.pRasterizationState = &rasterizer;
-        pipeline_info.pMultisampleState = &multisampling;
-        pipeline_info.pDepthStencilState = nullptr; // Optional
-        pipeline_info.pColorBlendState = &color_blending;
-        pipeline_info.pDynamicState = &dynamic_state;
-        pipeline_info.layout = pipeline_layout.get();
-        pipeline_info.renderPass = render_pass.get();
-        pipeline_info.subpass = 0;
-        pipeline_info.basePipelineHandle = VK_NULL_HANDLE; // Optional
-        pipeline_info.basePipelineIndex = -1; // Optional
-
-        VkPipeline temp_graphics_pipeline;
-        if (vkCreateGraphicsPipelines(device.get(),
-                                      VK_NULL_HANDLE,
-                                      1,
-                                      &pipeline_info,
-                                      nullptr,
-                                      &temp_graphics_pipeline) != VK_SUCCESS) {
-          throw std::runtime_error("failed to create graphics pipeline!");
-        }
+    // hot reloaded shader modules, written by the pipeline build on
+    // the pool and only read after it finished
+    std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>>
+      reloaded_vert_shader_module;
+    std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>>
+      reloaded_frag_shader_module;
+
+    // a build running on the pool submits parts to the pool as well,
+    // so it needs a second thread to make progress
+    WorkerPool pipeline_pool{std::clamp(std::thread::hardware_concurrency(), 2u, 4u)};
+
+    // with pipeline libraries the shader parts are compiled
+    // concurrently and linked with the cached interface parts,
+    // otherwise the pipeline is created in one piece
+    const auto build_graphics_pipeline = [&](const PipelineState& state) {
+      PROFILE_ZONE("build graphics pipeline");
+      if (!pipeline_library)
+        return create_pipeline_part(0, state);
+
+      auto vertex_input = pipeline_pool.submit([&, state]() {
+        return vertex_input_libraries.get(vertex_input_state(state));
+      });
+      auto fragment_output = pipeline_pool.submit([&, state]() {
+        return fragment_output_libraries.get(fragment_output_state(state));
+      });
+      auto pre_rasterization = pipeline_pool.submit([&, state]() {
+        return std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>>{
+          create_pipeline_part(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, state),
+          pipeline_deleter};
+      });
+      const std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>> fragment_shader{
+        create_pipeline_part(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, state), pipeline_deleter};
+      const auto pre_rasterization_library = pre_rasterization.get();
+
+      return link_graphics_pipeline(device.get(), pipeline_cache.get(), pipeline_layout.get(),
+                                    {vertex_input.get(), pre_rasterization_library.get(),
+                                     fragment_shader.get(), fragment_output.get()});
+    };
 
-        graphics_pipeline.reset(temp_graphics_pipeline);
-      }
+    // every combination of state gets built once, the variants only
+    // differ in dynamic state share a pipeline
+    PipelineVariantCache pipeline_variants{device.get(), build_graphics_pipeline};
+
+    PipelineState pipeline_state;
+    pipeline_state.vert_shader_module = vert_shader_module.get();
+    pipeline_state.frag_shader_module = frag_shader_module.get();
+    pipeline_state.render_pass = render_pass.get();
+    pipeline_state.color_format = color_format;
+    pipeline_state.instanced = instance_count > 0;
+    pipeline_state.blend_enable = VK_TRUE;
+    pipeline_state.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+    pipeline_state.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+    // reported at startup to keep track of it as variants are added
+    std::chrono::duration<double, std::milli> pipeline_build_time{0};
+    VkPipeline graphics_pipeline;
+    {
+      const auto pipeline_build_start = std::chrono::steady_clock::now();
+      graphics_pipeline = pipeline_variants.get(pipeline_state);
+      pipeline_build_time += std::chrono::steady_clock::now() - pipeline_build_start;
     }
 
     std::vector<std::unique_ptr<std::remove_pointer_t<VkFramebuffer>, std::function<void(VkFramebuffer)>>>
       swap_chain_framebuffers;
-    {
+    const auto create_framebuffers = [&]() {
       // https://vulkan-tutorial.com/Drawing_a_triangle/Drawing/Framebuffers
 
+      swap_chain_framebuffers.clear();
+      if (dynamic_rendering)
+        return;
+
       for (const auto& swap_chain_image_view : swap_chain_image_views) {
         VkImageView attachments[] = {
           swap_chain_image_view.get()
@@ -861,7 +1779,19 @@ int main(int argc, char** argv)
           vkDestroyFramebuffer(device.get(), framebuffer, nullptr);
         });
       }
-    }
+    };
+    create_framebuffers();
+
+    const auto render_target = [&](uint32_t image_index) {
+      RenderTarget target{};
+      target.render_pass = render_pass.get();
+      target.framebuffer = dynamic_rendering ? VK_NULL_HANDLE : swap_chain_framebuffers[image_index].get();
+      target.image = swap_chain_images[image_index];
+      target.image_view = swap_chain_image_views[image_index].get();
+      target.format = color_format;
+      target.final_layout = headless ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+      return target;
+    };
 
     std::unique_ptr<std::remove_pointer_t<VkCommandPool>, std::function<void(VkCommandPool)>> command_pool{
       nullptr,
@@ -869,12 +1799,8 @@ int main(int argc, char** argv)
         vkDestroyCommandPool(device.get(), command_pool, nullptr);
       }
     };
-    std::unique_ptr<std::remove_pointer_t<VkCommandBuffer>, std::function<void(VkCommandBuffer)>> command_buffer{
-      nullptr,
-      [&device, &command_pool](VkCommandBuffer command_buffer) {
-        vkFreeCommandBuffers(device.get(), command_pool.get(), 1, &command_buffer);
-      }
-    };
+    std::vector<std::unique_ptr<std::remove_pointer_t<VkCommandBuffer>, std::function<void(VkCommandBuffer)>>>
+      command_buffers;
     {
       // https://vulkan-tutorial.com/Drawing_a_triangle/Drawing/Command_buffers
 
@@ -895,72 +1821,90 @@ int main(int argc, char** argv)
       alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
       alloc_info.commandPool = command_pool.get();
       alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-      alloc_info.commandBufferCount = 1;
+      alloc_info.commandBufferCount = frames_in_flight;
 
-      VkCommandBuffer temp_command_buffer;
-      if (vkAllocateCommandBuffers(device.get(), &alloc_info, &temp_command_buffer) != VK_SUCCESS) {
+      std::vector<VkCommandBuffer> temp_command_buffers(frames_in_flight);
+      if (vkAllocateCommandBuffers(device.get(), &alloc_info, temp_command_buffers.data()) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate command buffers!");
       }
 
-      command_buffer.reset(temp_command_buffer);
+      for (const auto& temp_command_buffer : temp_command_buffers) {
+        command_buffers.emplace_back(temp_command_buffer, [&device, &command_pool](VkCommandBuffer command_buffer) {
+          vkFreeCommandBuffers(device.get(), command_pool.get(), 1, &command_buffer);
+        });
+      }
     }
 
-    // https://vulkan-tutorial.com/Drawing_a_triangle/Drawing/Rendering_and_presentation
-
-    std::unique_ptr<std::remove_pointer_t<VkSemaphore>, std::function<void(VkSemaphore)>> image_available_semaphore{
-      nullptr,
-      [&device](VkSemaphore semaphore) {
-        vkDestroySemaphore(device.get(), semaphore, nullptr);
-      }
-    };
-    std::unique_ptr<std::remove_pointer_t<VkSemaphore>, std::function<void(VkSemaphore)>> render_finished_semaphore{
-      nullptr,
-      [&device](VkSemaphore semaphore) {
-        vkDestroySemaphore(device.get(), semaphore, nullptr);
-      }
-    };
-    std::unique_ptr<std::remove_pointer_t<VkFence>, std::function<void(VkFence)>> in_flight_fence{
-      nullptr,
-      [&device](VkFence fence) {
-        vkDestroyFence(device.get(), fence, nullptr);
+    std::optional<GpuTimer> gpu_timer;
+    {
+      const uint32_t timestamp_valid_bits = queue_families[queue_family_index.value()].timestampValidBits;
+      if (prerecord) {
+        std::cout << "timestamp queries are per frame in flight, GPU timing disabled for prerecorded command buffers\n";
+      } else if (timestamp_valid_bits != 0) {
+        gpu_timer.emplace(device.get(), device_properties.limits.timestampPeriod, timestamp_valid_bits, frames_in_flight);
+      } else {
+        std::cout << "graphics queue does not support timestamps, GPU timing disabled\n";
       }
-    };
+    }
 
-    {
-      VkSemaphore temp_image_available_semaphore;
-      VkSemaphore temp_render_finished_semaphore;
-      VkFence temp_in_flight_fence;
+    // https://vulkan-tutorial.com/Drawing_a_triangle/Drawing/Frames_in_flight
 
-      VkSemaphoreCreateInfo semaphoreInfo{};
-      semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    std::vector<std::unique_ptr<std::remove_pointer_t<VkSemaphore>, std::function<void(VkSemaphore)>>>
+      image_available_semaphores;
+    // the presentation engine may still wait on a render finished
+    // semaphore when its frame slot comes around again, hence there
+    // is one per swap chain image instead of one per frame in flight
+    std::vector<std::unique_ptr<std::remove_pointer_t<VkSemaphore>, std::function<void(VkSemaphore)>>>
+      render_finished_semaphores;
 
-      VkFenceCreateInfo fenceInfo{};
-      fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-      fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    const auto semaphore_deleter = [&device](VkSemaphore semaphore) {
+      vkDestroySemaphore(device.get(), semaphore, nullptr);
+    };
 
-      if (vkCreateSemaphore(device.get(), &semaphoreInfo, nullptr, &temp_image_available_semaphore) != VK_SUCCESS ||
-          vkCreateSemaphore(device.get(), &semaphoreInfo, nullptr, &temp_render_finished_semaphore) != VK_SUCCESS ||
-          vkCreateFence(device.get(), &fenceInfo, nullptr, &temp_in_flight_fence) != VK_SUCCESS) {
+    for (uint32_t frame = 0; frame < frames_in_flight; ++frame) {
+      VkSemaphore temp_image_available_semaphore;
+      if (vkCreateSemaphore(device.get(), &semaphoreInfo, nullptr, &temp_image_available_semaphore) != VK_SUCCESS) {
         throw std::runtime_error("failed to create semaphores!");
       }
-
-      image_available_semaphore.reset(temp_image_available_semaphore);
-      render_finished_semaphore.reset(temp_render_finished_semaphore);
-      in_flight_fence.reset(temp_in_flight_fence);
+      image_available_semaphores.emplace_back(temp_image_available_semaphore, semaphore_deleter);
     }
 
+    // every submitted frame signals the next timeline value, a frame
+    // slot or swap chain image is free again once the value of its
+    // last frame has been reached
+    FrameTimeline frame_timeline{device.get()};
+    std::vector<uint64_t> frame_values(frames_in_flight, 0);
+
+    // only grows, a swap chain with fewer images leaves the surplus
+    // semaphores unused
+    const auto create_render_finished_semaphores = [&]() {
+      while (render_finished_semaphores.size() < swap_chain_images.size()) {
+        VkSemaphore temp_render_finished_semaphore;
+        if (vkCreateSemaphore(device.get(), &semaphoreInfo, nullptr, &temp_render_finished_semaphore) != VK_SUCCESS) {
+          throw std::runtime_error("failed to create semaphores!");
+        }
+        render_finished_semaphores.emplace_back(temp_render_finished_semaphore, semaphore_deleter);
+      }
+    };
+    create_render_finished_semaphores();
+
     // vertex buffers: https://vulkan-tutorial.com/Vertex_buffers/Vertex_input_description
 
     VkBufferCreateInfo buffer_info{};
     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     buffer_info.size = sizeof(vertices[0]) * vertices.size();
-    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    GpuAllocation vertex_buffer_allocation;
     std::unique_ptr<std::remove_pointer_t<VkBuffer>, std::function<void(VkBuffer)>> vertex_buffer{
       nullptr,
-      [&device](VkBuffer buffer) {
+      [&device, &allocator, &vertex_buffer_allocation](VkBuffer buffer) {
         vkDestroyBuffer(device.get(), buffer, nullptr);
+        allocator.free(vertex_buffer_allocation);
       }
     };
 
@@ -973,117 +1917,602 @@ int main(int argc, char** argv)
       vertex_buffer.reset(temp_buffer);
     }
 
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device.get(), vertex_buffer.get(), &mem_requirements);
-    std::cout << "memory requirements size: " << mem_requirements.size << '\n';
+    vertex_buffer_allocation = allocator.allocate_buffer_memory(vertex_buffer.get(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    std::cout << "memory requirements size: " << vertex_buffer_allocation.size << '\n';
 
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(physical_devices[0], &mem_properties);
+    // with culling the objects cover four times the visible area
+    const std::vector<Instance> instances = make_instances(instance_count, gpu_culling_enabled ? 2.0f : 1.0f);
 
-    const uint32_t type_filter = mem_requirements.memoryTypeBits;
-    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-    std::unique_ptr<std::remove_pointer_t<VkDeviceMemory>, std::function<void(VkDeviceMemory)>> vertex_buffer_memory{
+    GpuAllocation instance_buffer_allocation;
+    std::unique_ptr<std::remove_pointer_t<VkBuffer>, std::function<void(VkBuffer)>> instance_buffer{
       nullptr,
-      [&device](VkDeviceMemory mem) {
-        vkFreeMemory(device.get(), mem, nullptr);
+      [&device, &allocator, &instance_buffer_allocation](VkBuffer buffer) {
+        vkDestroyBuffer(device.get(), buffer, nullptr);
+        allocator.free(instance_buffer_allocation);
       }
     };
-    {
-      assert(mem_properties.memoryTypeCount < sizeof(type_filter) * 8);
-      uint32_t index = 0U;
-      const auto suitable_memory_type =
-        std::find_if(&mem_properties.memoryTypes[0], &mem_properties.memoryTypes[mem_properties.memoryTypeCount],
-                     [&index, &properties, &type_filter](const auto& element) {
-                       return ((type_filter & (1 << index++)) && (element.propertyFlags & properties) == properties);
-                     });
-
-      if (suitable_memory_type == &mem_properties.memoryTypes[mem_properties.memoryTypeCount]) {
-        throw std::runtime_error("no suitable memory found");
+
+    if (instance_count > 0) {
+      VkBufferCreateInfo instance_buffer_info{};
+      instance_buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+      instance_buffer_info.size = sizeof(instances[0]) * instances.size();
+      instance_buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+      if (gpu_culling_enabled)
+        instance_buffer_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+      instance_buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+      VkBuffer temp_buffer;
+      if (vkCreateBuffer(device.get(), &instance_buffer_info, nullptr, &temp_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create instance buffer!");
       }
 
-      VkMemoryAllocateInfo alloc_info{};
-      alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-      alloc_info.allocationSize = mem_requirements.size;
-      alloc_info.memoryTypeIndex = index - 1;
+      instance_buffer.reset(temp_buffer);
+      instance_buffer_allocation = allocator.allocate_buffer_memory(instance_buffer.get(),
+                                                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      std::cout << "instances: " << instance_count << ", "
+                << instance_count * vertices.size() / 3 << " triangles per frame\n";
+    }
 
-      VkDeviceMemory temp_vertex_buffer_memory;
-      if (vkAllocateMemory(device.get(), &alloc_info, nullptr, &temp_vertex_buffer_memory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
+    // https://vulkan-tutorial.com/Vertex_buffers/Staging_buffer
+    {
+      StagingUploader uploader{device.get(), allocator,
+                               transfer_queue_family_index, transfer_queue,
+                               queue_family_index.value(), graphics_queue};
+      uploader.enqueue(vertex_buffer.get(), 0, vertices.data(), buffer_info.size,
+                       VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+      if (instance_buffer) {
+        uploader.enqueue(instance_buffer.get(), 0, instances.data(), sizeof(instances[0]) * instances.size(),
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
       }
+      uploader.flush();
+    }
 
-      vertex_buffer_memory.reset(temp_vertex_buffer_memory);
+    std::optional<GpuCulling> gpu_culling;
+    if (gpu_culling_enabled) {
+      std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>> cull_shader_module{
+        load_shader_module(device.get(), shader_dir, "cull.spv"),
+        [&device](VkShaderModule shader_module) {
+          vkDestroyShaderModule(device.get(), shader_module, nullptr);
+        }
+      };
+      const auto pipeline_build_start = std::chrono::steady_clock::now();
+      gpu_culling.emplace(device.get(), allocator, pipeline_cache.get(), cull_shader_module.get(),
+                          device_properties.limits.minStorageBufferOffsetAlignment,
+                          instance_buffer.get(), instance_count, static_cast<uint32_t>(vertices.size()),
+                          frames_in_flight);
+      pipeline_build_time += std::chrono::steady_clock::now() - pipeline_build_start;
     }
+    std::cout << "pipelines built in " << pipeline_build_time.count() << " ms"
+              << (pipeline_library ? " from pipeline libraries\n" : "\n");
+
+    std::optional<ParallelRecorder> parallel_recorder;
+    if (record_threads > 0)
+      parallel_recorder.emplace(device.get(), queue_family_index.value(), record_threads, frames_in_flight);
+
+    // CPU time spent recording a frame, the main cost that parallel
+    // recording distributes over the cores
+    RollingStatistics recording_times{1024};
+
+    // with --prerecord every framebuffer gets its own command buffer,
+    // which is only recorded again after the swap chain or the scene
+    // changed
+    std::vector<std::unique_ptr<std::remove_pointer_t<VkCommandBuffer>, std::function<void(VkCommandBuffer)>>>
+      image_command_buffers;
+    bool image_command_buffers_valid = false;
+    // the uniform ranges baked into them, rewritten every frame once the
+    // image's previous frame completed
+    std::vector<UniformRing::Range> image_uniforms;
+    // must only be called while none of the command buffers is pending
+    const auto record_image_command_buffers = [&]() {
+      if (image_command_buffers.size() < swap_chain_image_views.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = command_pool.get();
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = static_cast<uint32_t>(swap_chain_image_views.size() - image_command_buffers.size());
+
+        std::vector<VkCommandBuffer> temp_command_buffers(alloc_info.commandBufferCount);
+        if (vkAllocateCommandBuffers(device.get(), &alloc_info, temp_command_buffers.data()) != VK_SUCCESS) {
+          throw std::runtime_error("failed to allocate command buffers!");
+        }
+
+        for (const auto& temp_command_buffer : temp_command_buffers) {
+          image_command_buffers.emplace_back(temp_command_buffer, [&device, &command_pool](VkCommandBuffer command_buffer) {
+            vkFreeCommandBuffers(device.get(), command_pool.get(), 1, &command_buffer);
+          });
+        }
+      }
+
+      // no range is tagged with a frame, they stay until the next call
+      uniform_ring.reset();
+      image_uniforms.clear();
+      for (uint32_t i = 0; i < swap_chain_image_views.size(); ++i) {
+        image_uniforms.push_back(uniform_ring.allocate(sizeof(FrameUniforms)));
+
+        vkResetCommandBuffer(image_command_buffers[i].get(), 0);
+        const FrameBindings frame_bindings{pipeline_layout.get(), uniform_ring.descriptor_set(),
+                                           image_uniforms[i].offset};
+        record_command_buffer(*image_command_buffers[i], *graphics_pipeline, frame_bindings, render_target(i),
+                              actual_extent, vertex_buffer.get(),
+                              instance_buffer.get(), std::max(instance_count, 1u), draw_per_instance,
+                              nullptr, nullptr, nullptr, 0);
+      }
+      image_command_buffers_valid = true;
+    };
 
-    vkBindBufferMemory(device.get(), vertex_buffer.get(), vertex_buffer_memory.get(), 0);
-
-    void* data;
-    vkMapMemory(device.get(), vertex_buffer_memory.get(), 0, buffer_info.size, 0, &data);
-    memcpy(data, vertices.data(), (size_t) buffer_info.size);
-    vkUnmapMemory(device.get(), vertex_buffer_memory.get());
-
-    window.show();
-    while (!window.should_close()) {
-      context.clear();
-
-      VkFence fences[] = {in_flight_fence.get()};
-      vkWaitForFences(device.get(), 1, fences, VK_TRUE, std::numeric_limits<uint64_t>::max());
-      vkResetFences(device.get(), 1, fences);
-
-      uint32_t image_index;
-      vkAcquireNextImageKHR(device.get(),
-                            swap_chain.get(),
-                            std::numeric_limits<uint64_t>::max(),
-                            image_available_semaphore.get(),
-                            VK_NULL_HANDLE,
-                            &image_index);
-
-      vkResetCommandBuffer(command_buffer.get(), 0);
-
-      record_command_buffer(*command_buffer, *graphics_pipeline, *render_pass,
-                            *swap_chain_framebuffers[image_index], actual_extent, vertex_buffer.get());
-
-      // record command buffer
-      VkSubmitInfo submitInfo{};
-      submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-      VkSemaphore waitSemaphores[] = {image_available_semaphore.get()};
-      VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-      submitInfo.waitSemaphoreCount = 1;
-      submitInfo.pWaitSemaphores = waitSemaphores;
-      submitInfo.pWaitDstStageMask = waitStages;
-      submitInfo.commandBufferCount = 1;
-      VkCommandBuffer command_buffers[] = {command_buffer.get()};
-      submitInfo.pCommandBuffers = command_buffers;
-
-      VkSemaphore signalSemaphores[] = {render_finished_semaphore.get()};
-      submitInfo.signalSemaphoreCount = 1;
-      submitInfo.pSignalSemaphores = signalSemaphores;
-
-      if (vkQueueSubmit(graphics_queue, 1, &submitInfo, in_flight_fence.get()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    // with --watch-shaders a changed shader is built into a new
+    // pipeline on a background thread while the frames keep using the
+    // current one, the swap happens between two frames
+    std::optional<FileWatcher> shader_watcher;
+    if (watch_shaders)
+      shader_watcher.emplace(*shader_dir);
+    bool pipeline_rebuild_requested = false;
+    // replaced pipelines and the timeline value of the last frame
+    // which may still use them
+    std::vector<std::pair<uint64_t, std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>>>>
+      retired_pipelines;
+    // only refers to objects declared before the pool, which joins
+    // a running build before anything it uses is destroyed
+    const auto build_pipeline = [&, build_graphics_pipeline](PipelineState state) {
+      const auto shader_module_deleter = [&device](VkShaderModule shader_module) {
+        vkDestroyShaderModule(device.get(), shader_module, nullptr);
+      };
+      reloaded_vert_shader_module = std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>>{
+        load_shader_module(device.get(), shader_dir, vert_shader_name), shader_module_deleter};
+      reloaded_frag_shader_module = std::unique_ptr<std::remove_pointer_t<VkShaderModule>, std::function<void(VkShaderModule)>>{
+        load_shader_module(device.get(), shader_dir, frag_shader_name), shader_module_deleter};
+
+      state.vert_shader_module = reloaded_vert_shader_module.get();
+      state.frag_shader_module = reloaded_frag_shader_module.get();
+      return std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>>{
+        build_graphics_pipeline(state), pipeline_deleter};
+    };
+    std::future<std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>>> pipeline_build;
+
+    // starts a build for changed shaders and swaps in a finished one,
+    // only called between frames
+    const auto reload_shaders = [&]() {
+      const auto changed = shader_watcher->poll();
+      if (std::find(changed.begin(), changed.end(), vert_shader_name) != changed.end() ||
+          std::find(changed.begin(), changed.end(), frag_shader_name) != changed.end())
+        pipeline_rebuild_requested = true;
+
+      // changes during a build start another one after it finished
+      if (pipeline_rebuild_requested && !pipeline_build.valid()) {
+        pipeline_build = pipeline_pool.submit([build_pipeline, state = pipeline_state]() { return build_pipeline(state); });
+        pipeline_rebuild_requested = false;
       }
 
-      VkPresentInfoKHR presentInfo{};
-      presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-      presentInfo.waitSemaphoreCount = 1;
-      presentInfo.pWaitSemaphores = signalSemaphores;
-      VkSwapchainKHR swapChains[] = {swap_chain.get()};
-      presentInfo.swapchainCount = 1;
-      presentInfo.pSwapchains = swapChains;
-      presentInfo.pImageIndices = &image_index;
-      presentInfo.pResults = nullptr; // Optional
+      if (pipeline_build.valid() && pipeline_build.wait_for(std::chrono::seconds{0}) == std::future_status::ready) {
+        try {
+          auto pipeline = pipeline_build.get();
+
+          // no variant built from the previous shaders is used again
+          const VkShaderModule previous_vert_shader_module = pipeline_state.vert_shader_module;
+          const VkShaderModule previous_frag_shader_module = pipeline_state.frag_shader_module;
+          const auto previous_pipelines = pipeline_variants.extract_if([&](const PipelineState& state) {
+            return state.vert_shader_module == previous_vert_shader_module ||
+                   state.frag_shader_module == previous_frag_shader_module;
+          });
+          for (VkPipeline previous_pipeline : previous_pipelines) {
+            retired_pipelines.emplace_back(
+              frame_timeline.last_value(),
+              std::unique_ptr<std::remove_pointer_t<VkPipeline>, std::function<void(VkPipeline)>>{
+                previous_pipeline, pipeline_deleter});
+          }
+
+          // the pipelines do not need their shader modules anymore
+          vert_shader_module = std::move(reloaded_vert_shader_module);
+          frag_shader_module = std::move(reloaded_frag_shader_module);
+          pipeline_state.vert_shader_module = vert_shader_module.get();
+          pipeline_state.frag_shader_module = frag_shader_module.get();
+          graphics_pipeline = pipeline_variants.insert(pipeline_state, pipeline.release());
+
+          // prerecorded command buffers have the old pipeline baked in
+          // and must not be pending when they are recorded again
+          if (prerecord) {
+            frame_timeline.wait(frame_timeline.last_value());
+            image_command_buffers_valid = false;
+          }
+          std::cout << "reloaded " << vert_shader_name << " and " << frag_shader_name << '\n';
+        } catch (const std::exception& e) {
+          // a broken shader keeps the previous pipeline
+          reloaded_vert_shader_module.reset();
+          reloaded_frag_shader_module.reset();
+          std::cerr << "reloading shaders failed: " << e.what() << '\n';
+        }
+      }
 
-      vkQueuePresentKHR(graphics_queue, &presentInfo);
+      if (!retired_pipelines.empty()) {
+        const uint64_t completed_value = frame_timeline.completed_value();
+        retired_pipelines.erase(std::remove_if(retired_pipelines.begin(), retired_pipelines.end(),
+                                               [completed_value](const auto& retired) {
+                                                 return retired.first <= completed_value;
+                                               }),
+                                retired_pipelines.end());
+      }
+    };
+
+    // timeline value of the last frame that rendered into a swap chain
+    // image, 0 if the image has never been used
+    std::vector<uint64_t> images_in_flight(swap_chain_images.size(), 0);
+    uint32_t current_frame = 0;
+    uint64_t frame_count = 0;
+    // present ids are the timeline values of the presented frames, only
+    // the ones presented to the current swap chain can be waited for
+    std::deque<uint64_t> present_ids;
+
+    FrameLimiter::Clock limiter_clock = []() {
+      return std::chrono::duration<double>{std::chrono::steady_clock::now().time_since_epoch()}.count();
+    };
+    if (context)
+      limiter_clock = [&context]() { return context->time(); };
+    std::optional<FrameLimiter> frame_limiter;
+    if (max_fps > 0.0)
+      frame_limiter.emplace(max_fps, limiter_clock);
+    // the refresh period the frame limiter paces to, 0 while it does not
+    double paced_refresh_period = 0.0;
+
+    // render pass, pipeline and frame resources survive, the
+    // pipeline uses dynamic viewport and scissor state
+    const auto recreate_swap_chain = [&]() {
+      PROFILE_ZONE("recreate swap chain");
+      vkDeviceWaitIdle(device.get());
+
+      swap_chain_framebuffers.clear();
+      swap_chain_image_views.clear();
+      create_swap_chain();
+      create_image_views();
+      create_framebuffers();
+      create_render_finished_semaphores();
+      images_in_flight.assign(swap_chain_images.size(), 0);
+      image_command_buffers_valid = false;
+      present_ids.clear();
+      framebuffer_resized = false;
+    };
 
-      context.pool_events();
+    // set by the main thread when the window is closed, or by the
+    // render thread on escape
+    std::atomic<bool> close_requested{false};
+
+    // recordings are relative to the start of the render loop
+    std::optional<InputRecorder> input_recorder;
+    if (parse_result.count("record-input"))
+      input_recorder.emplace(parse_result["record-input"].as<std::string>());
+    std::optional<InputPlayback> input_playback;
+    if (parse_result.count("replay-input"))
+      input_playback.emplace(parse_result["replay-input"].as<std::string>());
+    double input_start_time = 0.0;
+
+    const auto handle_input_event = [&](const InputEvent& event) {
+      if (input_recorder) {
+        if (event.type == InputEvent::Type::KEY)
+          input_recorder->record_key(event.time - input_start_time, event.code, event.action);
+        else if (event.type == InputEvent::Type::RESIZE)
+          input_recorder->record_resize(event.time - input_start_time, event.width, event.height);
+      }
+
+      switch (event.type) {
+      case InputEvent::Type::KEY:
+        if (event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS)
+          close_requested = true;
+        break;
+      case InputEvent::Type::JOYSTICK:
+        std::cout << "joystick " << event.code
+                  << (event.action == GLFW_CONNECTED ? " connected\n" : " disconnected\n");
+        break;
+      case InputEvent::Type::RESIZE:
+        framebuffer_size = {event.width, event.height};
+        framebuffer_resized = true;
+        break;
+      }
+    };
+
+    const auto should_close = [&]() {
+      if (max_frames != 0 && frame_count == max_frames)
+        return true;
+
+      return window ? close_requested.load() : interrupted != 0;
+    };
+
+    const auto start_time = std::chrono::steady_clock::now();
+    if (context)
+      input_start_time = context->time();
+    const auto render_loop = [&]() {
+      while (!should_close()) {
+        PROFILE_ZONE("frame");
+        while (const auto event = input_events.try_pop())
+          handle_input_event(*event);
+
+        if (input_playback) {
+          // a fast replay hands the input to the same frames every run
+          double playback_time = static_cast<double>(frame_count) / 60.0;
+          if (!replay_fast) {
+            playback_time = context
+              ? context->time() - input_start_time
+              : std::chrono::duration<double>{std::chrono::steady_clock::now() - start_time}.count();
+          }
+
+          while (const auto* record = input_playback->next(playback_time)) {
+            if (record->type == input_recording::RecordType::KEY) {
+              handle_input_event({InputEvent::Type::KEY, record->code, record->action, 0, 0, record->time});
+            } else if (record->type == input_recording::RecordType::RESIZE) {
+              // the window keeps its real size, a recorded resize only
+              // recreates the swap chain at the size the window has, so
+              // a recorded minimize cannot stall the replay
+              framebuffer_resized = true;
+            }
+          }
+        }
+
+        if (context)
+          context->clear();
+
+        if (window) {
+          // a minimized window has no framebuffer to render into, the
+          // next resize event brings it back
+          if (framebuffer_size.first == 0 || framebuffer_size.second == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            continue;
+          }
+
+          // moving the window to a monitor with another refresh rate
+          // may change how many images the swap chain should have
+          const double current_refresh_period = refresh_period;
+          if (current_refresh_period != swap_chain_refresh_period &&
+              swap_chain_image_count(details.capabilities, frames_in_flight, current_refresh_period) !=
+              swap_chain_image_count(details.capabilities, frames_in_flight, swap_chain_refresh_period))
+            framebuffer_resized = true;
+
+          if (framebuffer_resized)
+            recreate_swap_chain();
+
+          // mailbox does not block, without a limit it renders frames
+          // that are never displayed, immediate is left uncapped for
+          // the lowest latency
+          if (pace_to_refresh && present_mode == VK_PRESENT_MODE_MAILBOX_KHR &&
+              current_refresh_period > 0.0 && current_refresh_period != paced_refresh_period) {
+            frame_limiter.emplace(1.0 / current_refresh_period, limiter_clock);
+            paced_refresh_period = current_refresh_period;
+          }
+        }
+
+        // with fifo the swap chain alone lets the CPU run a frame per
+        // image ahead of the display
+        if (present_ids.size() >= frames_in_flight) {
+          PROFILE_ZONE("wait for present");
+          const VkResult result = wait_for_present(device.get(), swap_chain.get(), present_ids.front(),
+                                                   std::chrono::nanoseconds{std::chrono::seconds{1}}.count());
+          present_ids.pop_front();
+          if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            framebuffer_resized = true;
+          } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_TIMEOUT) {
+            throw std::runtime_error("failed to wait for present!");
+          }
+        }
+
+        if (frame_limiter) {
+          PROFILE_ZONE("frame limiter");
+          frame_limiter->wait();
+        }
+
+        {
+          PROFILE_ZONE("wait for frame");
+          frame_timeline.wait(frame_values[current_frame]);
+        }
+        if (gpu_timer)
+          gpu_timer->collect(current_frame);
+        if (shader_watcher)
+          reload_shaders();
+
+        // offscreen images are owned by their frame slot
+        uint32_t image_index = current_frame;
+        if (!headless) {
+          PROFILE_ZONE("acquire image");
+          const VkResult result = vkAcquireNextImageKHR(device.get(),
+                                                        swap_chain.get(),
+                                                        std::numeric_limits<uint64_t>::max(),
+                                                        image_available_semaphores[current_frame].get(),
+                                                        VK_NULL_HANDLE,
+                                                        &image_index);
+          if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreate_swap_chain();
+            continue;
+          } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+          }
+        }
+
+        // the acquired image may still be rendered to by an older frame
+        // if the swap chain has fewer images than frames in flight or
+        // the images are returned out of order
+        {
+          PROFILE_ZONE("wait for image");
+          frame_timeline.wait(images_in_flight[image_index]);
+        }
+
+        const std::chrono::duration<float> time = std::chrono::steady_clock::now() - start_time;
+        const FrameUniforms frame_uniforms{{1.0f, 1.0f, 0.0f, 0.0f}, time.count()};
+
+        const auto recording_start = std::chrono::steady_clock::now();
+        VkCommandBuffer command_buffer;
+        if (prerecord) {
+          if (!image_command_buffers_valid)
+            record_image_command_buffers();
+          command_buffer = image_command_buffers[image_index].get();
+          std::memcpy(image_uniforms[image_index].data, &frame_uniforms, sizeof(frame_uniforms));
+        } else {
+          command_buffer = command_buffers[current_frame].get();
+          vkResetCommandBuffer(command_buffer, 0);
+
+          uniform_ring.release(frame_timeline.completed_value());
+          const FrameBindings frame_bindings{pipeline_layout.get(), uniform_ring.descriptor_set(),
+                                             uniform_ring.write(&frame_uniforms, sizeof(frame_uniforms))};
+          record_command_buffer(*command_buffer, *graphics_pipeline, frame_bindings, render_target(image_index),
+                                actual_extent, vertex_buffer.get(),
+                                instance_buffer.get(), std::max(instance_count, 1u), draw_per_instance,
+                                parallel_recorder ? &*parallel_recorder : nullptr,
+                                gpu_culling ? &*gpu_culling : nullptr,
+                                gpu_timer ? &*gpu_timer : nullptr, current_frame);
+        }
+        const std::chrono::duration<double, std::milli> recording_time = std::chrono::steady_clock::now() - recording_start;
+        recording_times.add(recording_time.count());
+
+        const uint64_t frame_value = frame_timeline.advance();
+        frame_values[current_frame] = frame_value;
+        images_in_flight[image_index] = frame_value;
+        if (!prerecord)
+          uniform_ring.end_frame(frame_value);
+
+        VkSemaphoreSubmitInfo wait_semaphore_info{};
+        wait_semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        wait_semaphore_info.semaphore = image_available_semaphores[current_frame].get();
+        wait_semaphore_info.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+        VkCommandBufferSubmitInfo command_buffer_info{};
+        command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        command_buffer_info.commandBuffer = command_buffer;
+
+        // the timeline value always comes first, the binary semaphore
+        // for presentation is only signaled with a swap chain
+        std::array<VkSemaphoreSubmitInfo, 2> signal_semaphore_infos{};
+        signal_semaphore_infos[0].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        signal_semaphore_infos[0].semaphore = frame_timeline.get();
+        signal_semaphore_infos[0].value = frame_value;
+        signal_semaphore_infos[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        signal_semaphore_infos[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        signal_semaphore_infos[1].semaphore = render_finished_semaphores[image_index].get();
+        signal_semaphore_infos[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo2 submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+        submit_info.waitSemaphoreInfoCount = headless ? 0 : 1;
+        submit_info.pWaitSemaphoreInfos = &wait_semaphore_info;
+        submit_info.commandBufferInfoCount = 1;
+        submit_info.pCommandBufferInfos = &command_buffer_info;
+        submit_info.signalSemaphoreInfoCount = headless ? 1 : 2;
+        submit_info.pSignalSemaphoreInfos = signal_semaphore_infos.data();
+
+        {
+          PROFILE_ZONE("submit");
+          if (vkQueueSubmit2(graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+          }
+        }
+
+        current_frame = (current_frame + 1) % frames_in_flight;
+        ++frame_count;
+
+        if (headless)
+          continue;
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        VkSemaphore render_finished_semaphore = render_finished_semaphores[image_index].get();
+        presentInfo.pWaitSemaphores = &render_finished_semaphore;
+        VkSwapchainKHR swapChains[] = {swap_chain.get()};
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+        presentInfo.pImageIndices = &image_index;
+        presentInfo.pResults = nullptr; // Optional
+
+        VkPresentIdKHR present_id_info{};
+        present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        present_id_info.swapchainCount = 1;
+        present_id_info.pPresentIds = &frame_value;
+        if (present_wait)
+          presentInfo.pNext = &present_id_info;
+
+        VkResult result;
+        {
+          PROFILE_ZONE("present");
+          result = vkQueuePresentKHR(graphics_queue, &presentInfo);
+        }
+        if (present_wait && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR))
+          present_ids.push_back(frame_value);
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+          framebuffer_resized = true;
+        } else if (result != VK_SUCCESS) {
+          throw std::runtime_error("failed to present swap chain image!");
+        }
+      }
+    };
+
+    if (window) {
+      window->show();
+
+      // the main thread only waits for events, so input is handled
+      // right away no matter how long a frame takes
+      std::atomic<bool> render_finished{false};
+      std::exception_ptr render_error;
+      std::thread render_thread{[&]() {
+        PROFILE_THREAD_NAME("render");
+        try {
+          render_loop();
+        } catch (...) {
+          render_error = std::current_exception();
+        }
+        render_finished = true;
+        context->post_empty_event();
+      }};
+
+      while (!render_finished) {
+        {
+          PROFILE_ZONE("wait events");
+          context->wait_events();
+        }
+        if (window->should_close())
+          close_requested = true;
+        refresh_period = monitor_database->refresh_period(window->raw_glfw_window());
+      }
+      render_thread.join();
+
+      if (render_error)
+        std::rethrow_exception(render_error);
+    } else {
+      render_loop();
     }
 
     vkDeviceWaitIdle(device.get());
+
+    if (input_recorder)
+      input_recorder->flush();
+
+    try {
+      pipeline_cache.save();
+    } catch (const std::exception& e) {
+      std::cerr << "saving pipeline cache failed: " << e.what() << '\n';
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    std::cout << "rendered " << frame_count << " frames in " << elapsed.count() << " s ("
+              << static_cast<double>(frame_count) / elapsed.count() << " fps)\n";
+
+    {
+      const auto recording = recording_times.summary();
+      std::cout << "cpu recording time over the last " << recording.count << " frames (ms) with "
+                << record_threads << " recording threads: min " << recording.min << ", avg " << recording.avg
+                << ", p99 " << recording.p99 << ", max " << recording.max << '\n';
+    }
+
+    allocator.print_statistics(std::cout);
+
+    if (gpu_timer) {
+      for (uint32_t frame = 0; frame < frames_in_flight; ++frame) {
+        gpu_timer->collect(frame);
+      }
+      gpu_timer->print(std::cout);
+    }
   } catch (const std::exception &e) {
     std::cerr << e.what() << '\n';
+    write_trace();
     return EXIT_FAILURE;
   }
 
+  write_trace();
+
   return EXIT_SUCCESS;
 }
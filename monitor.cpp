@@ -1,45 +1,37 @@
 #include "graphics.hpp"
+#include "monitor_database.hpp"
 
 #include "GLFW/glfw3.h"
 
 #include <cstdlib>
 #include <iostream>
 
-namespace {
-  void monitor_callback(GLFWmonitor* monitor, int event)
-  {
-    if (event == GLFW_CONNECTED)
-    {
-      std::cout << "monitor connected\n";
-    }
-    else if (event == GLFW_DISCONNECTED)
-    {
-      std::cout << "monitor disconnected\n";
-    }
-  }
-}
-
 int main()
 {
   GraphicsContext context;
-  glfwSetMonitorCallback(monitor_callback);
-
-  GLFWmonitor* primary = glfwGetPrimaryMonitor();
+  MonitorDatabase database;
+
+  const auto& monitors = database.monitors();
+  std::cout << "monitor count: " << monitors.size() << '\n';
+  for (const auto& monitor : monitors) {
+    std::cout << "monitor name: " << monitor.name << ", xpos: " << monitor.x << ", ypos: " << monitor.y
+              << ", current mode: " << monitor.current_mode.width << ", " << monitor.current_mode.height
+              << " @ " << monitor.current_mode.refreshRate << " Hz\n";
+    for (const auto& mode : monitor.modes) {
+      std::cout << '\t' << mode.width << ", " << mode.height << " @ " << mode.refreshRate << " Hz\n";
+    }
 
-  int count;
-  GLFWmonitor** monitors = glfwGetMonitors(&count);
-  std::cout << "monitor count: " << count << '\n';
-  for (int index = 0; index < count; ++index) {
-    const GLFWvidmode* modes = glfwGetVideoModes(monitors[index], &count);
-    if (modes != nullptr) {
-      for (int index = 0; index < count; ++index) {
-        std::cout << modes[index].width << ", " << modes[index].height << '\n';
-      }
+    if (const auto best = MonitorDatabase::best_mode(monitor.modes,
+                                                     monitor.current_mode.width,
+                                                     monitor.current_mode.height)) {
+      std::cout << "best mode at the current resolution: " << best->refreshRate << " Hz\n";
     }
   }
 
-  const char* name = glfwGetMonitorName(primary);
-  std::cout << "monitor name: " << name << '\n';
+  // the primary monitor is always the first one
+  if (monitors.empty())
+    return EXIT_SUCCESS;
+  GLFWmonitor* primary = monitors.front().monitor;
 
   {
     int xpos, ypos, width, height;
@@ -47,24 +39,11 @@ int main()
     std::cout << "xpos: " << xpos << ", ypos: " << ypos << ", width: " << width << ", height: " << height << '\n';
   }
 
-  {
-    int xpos, ypos;
-    glfwGetMonitorPos(primary, &xpos, &ypos);
-    std::cout << "xpos: " << xpos << ", ypos: " << ypos << '\n';
-  }
-
   {
     int width_mm, height_mm;
     glfwGetMonitorPhysicalSize(primary, &width_mm, &height_mm);
     std::cout << "physical size - width_mm: " << width_mm << ", height_mm: " << height_mm << '\n';
   }
 
-  const GLFWvidmode* modes = glfwGetVideoModes(primary, &count);
-  if (modes != nullptr) {
-    for (int index = 0; index < count; ++index) {
-      std::cout << modes[index].width << ", " << modes[index].height << '\n';
-    }
-  }
-
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,129 @@
+#include "monitor_database.hpp"
+
+#include <stdexcept>
+
+namespace {
+  MonitorDatabase* database = nullptr;
+}
+
+MonitorDatabase::MonitorDatabase()
+{
+  if (database != nullptr) {
+    throw std::logic_error("only one monitor database may exist at a time!");
+  }
+
+  database = this;
+  glfwSetMonitorCallback(monitor_callback);
+  refresh();
+}
+
+MonitorDatabase::~MonitorDatabase()
+{
+  glfwSetMonitorCallback(nullptr);
+  database = nullptr;
+}
+
+void MonitorDatabase::monitor_callback(GLFWmonitor* monitor, int event)
+{
+  // the monitor list is already updated when the callback runs
+  if (database != nullptr)
+    database->refresh();
+}
+
+void MonitorDatabase::refresh()
+{
+  monitor_infos.clear();
+
+  int monitor_count = 0;
+  GLFWmonitor** monitors = glfwGetMonitors(&monitor_count);
+  for (int monitor_index = 0; monitor_index < monitor_count; ++monitor_index) {
+    MonitorInfo info{};
+    info.monitor = monitors[monitor_index];
+    const char* name = glfwGetMonitorName(info.monitor);
+    info.name = name != nullptr ? name : "";
+    glfwGetMonitorPos(info.monitor, &info.x, &info.y);
+
+    const GLFWvidmode* current_mode = glfwGetVideoMode(info.monitor);
+    if (current_mode != nullptr)
+      info.current_mode = *current_mode;
+
+    int mode_count = 0;
+    const GLFWvidmode* modes = glfwGetVideoModes(info.monitor, &mode_count);
+    if (modes != nullptr)
+      info.modes.assign(modes, modes + mode_count);
+
+    monitor_infos.push_back(std::move(info));
+  }
+
+  ++refresh_count;
+}
+
+const std::vector<MonitorInfo>& MonitorDatabase::monitors() const
+{
+  return monitor_infos;
+}
+
+uint64_t MonitorDatabase::generation() const
+{
+  return refresh_count;
+}
+
+const MonitorInfo* MonitorDatabase::monitor_of(GLFWwindow* window) const
+{
+  if (monitor_infos.empty())
+    return nullptr;
+
+  // a full screen window knows its monitor
+  if (GLFWmonitor* monitor = glfwGetWindowMonitor(window)) {
+    for (const auto& info : monitor_infos) {
+      if (info.monitor == monitor)
+        return &info;
+    }
+  }
+
+  int x, y, width, height;
+  glfwGetWindowPos(window, &x, &y);
+  glfwGetWindowSize(window, &width, &height);
+  if (const MonitorInfo* info = monitor_at(monitor_infos, x + width / 2, y + height / 2))
+    return info;
+
+  // e.g. Wayland does not report window positions
+  return &monitor_infos.front();
+}
+
+double MonitorDatabase::refresh_period(GLFWwindow* window) const
+{
+  const MonitorInfo* info = monitor_of(window);
+  if (info == nullptr || info->current_mode.refreshRate <= 0)
+    return 0.0;
+
+  return 1.0 / info->current_mode.refreshRate;
+}
+
+std::optional<GLFWvidmode> MonitorDatabase::best_mode(const std::vector<GLFWvidmode>& modes, int width, int height)
+{
+  std::optional<GLFWvidmode> best;
+  for (const auto& mode : modes) {
+    if (mode.width != width || mode.height != height)
+      continue;
+
+    // GLFW sorts modes by color depth first, the deeper mode wins a tie
+    if (!best || mode.refreshRate > best->refreshRate ||
+        (mode.refreshRate == best->refreshRate &&
+         mode.redBits + mode.greenBits + mode.blueBits > best->redBits + best->greenBits + best->blueBits))
+      best = mode;
+  }
+
+  return best;
+}
+
+const MonitorInfo* MonitorDatabase::monitor_at(const std::vector<MonitorInfo>& monitors, int x, int y)
+{
+  for (const auto& info : monitors) {
+    if (x >= info.x && x < info.x + info.current_mode.width &&
+        y >= info.y && y < info.y + info.current_mode.height)
+      return &info;
+  }
+
+  return nullptr;
+}
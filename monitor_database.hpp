@@ -0,0 +1,61 @@
+#ifndef MONITOR_DATABASE_HPP
+#define MONITOR_DATABASE_HPP
+
+#include "GLFW/glfw3.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct MonitorInfo
+{
+  GLFWmonitor* monitor;
+  std::string name;
+  //! position of the monitor in the virtual desktop
+  int x;
+  int y;
+  GLFWvidmode current_mode;
+  std::vector<GLFWvidmode> modes;
+};
+
+//! caches the monitors and their video modes, the cache is refreshed
+//! whenever GLFW reports a monitor being connected or disconnected
+//!
+//! Installs the GLFW monitor callback, so only one database may exist
+//! at a time. Like all GLFW monitor functions it must only be used on
+//! the main thread.
+class MonitorDatabase
+{
+public:
+  MonitorDatabase();
+  MonitorDatabase(const MonitorDatabase&) = delete;
+  MonitorDatabase& operator=(const MonitorDatabase&) = delete;
+  ~MonitorDatabase();
+
+  void refresh();
+  //! the primary monitor comes first
+  const std::vector<MonitorInfo>& monitors() const;
+  //! counts the refreshes, changes whenever the monitors changed
+  uint64_t generation() const;
+
+  //! the monitor the center of \p window is on, the primary monitor if
+  //! it is on none, nullptr without monitors
+  const MonitorInfo* monitor_of(GLFWwindow* window) const;
+  //! seconds between two refreshes of the monitor \p window is on, 0
+  //! if unknown
+  double refresh_period(GLFWwindow* window) const;
+
+  //! the mode of \p width x \p height with the highest refresh rate
+  static std::optional<GLFWvidmode> best_mode(const std::vector<GLFWvidmode>& modes, int width, int height);
+  //! the monitor whose current mode covers the point, nullptr if none does
+  static const MonitorInfo* monitor_at(const std::vector<MonitorInfo>& monitors, int x, int y);
+
+private:
+  static void monitor_callback(GLFWmonitor* monitor, int event);
+
+  std::vector<MonitorInfo> monitor_infos;
+  uint64_t refresh_count = 0;
+};
+
+#endif // MONITOR_DATABASE_HPP
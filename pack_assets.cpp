@@ -0,0 +1,65 @@
+#include "asset_pack.hpp"
+
+#include "cxxopts.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+  std::vector<std::byte> read_file(const std::filesystem::path& path)
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      throw std::runtime_error("failed to open \"" + path.string() + "\"!");
+    }
+
+    std::vector<std::byte> data(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      throw std::runtime_error("failed to read \"" + path.string() + "\"!");
+    }
+
+    return data;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  cxxopts::Options options(argv[0], "packs files into an asset pack, each named after its file name");
+  options.add_options()
+    ("o,output", "asset pack to write", cxxopts::value<std::string>())
+    ("a,alignment", "alignment of every asset in bytes", cxxopts::value<uint32_t>()->default_value("16"))
+    ("inputs", "files to pack", cxxopts::value<std::vector<std::string>>())
+    ("h,help", "Print usage");
+  options.parse_positional({"inputs"});
+  options.positional_help("FILE...");
+
+  try {
+    const auto parse_result = options.parse(argc, argv);
+
+    if (parse_result.count("help") || !parse_result.count("output")) {
+      std::cout << options.help() << std::endl;
+      return parse_result.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    const auto alignment = parse_result["alignment"].as<uint32_t>();
+    AssetPackWriter writer;
+    if (parse_result.count("inputs")) {
+      for (const auto& input : parse_result["inputs"].as<std::vector<std::string>>()) {
+        const std::filesystem::path path{input};
+        writer.add(path.filename().string(), read_file(path), alignment);
+      }
+    }
+
+    writer.write(parse_result["output"].as<std::string>());
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+#include "parallel_recorder.hpp"
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+ParallelRecorder::ParallelRecorder(VkDevice device,
+                                   uint32_t queue_family_index,
+                                   uint32_t thread_count,
+                                   uint32_t frames_in_flight) :
+    device{device},
+    thread_count{thread_count},
+    command_pools(static_cast<std::size_t>(thread_count) * frames_in_flight, VK_NULL_HANDLE),
+    command_buffers(command_pools.size(), VK_NULL_HANDLE),
+    slice_counts(thread_count, 0),
+    errors(thread_count)
+{
+  if (thread_count == 0) {
+    throw std::invalid_argument("parallel recording needs at least one thread");
+  }
+
+  try {
+    for (std::size_t i = 0; i < command_pools.size(); ++i) {
+      VkCommandPoolCreateInfo pool_info{};
+      pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+      pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+      pool_info.queueFamilyIndex = queue_family_index;
+      if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pools[i]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create recording command pool!");
+      }
+
+      VkCommandBufferAllocateInfo alloc_info{};
+      alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      alloc_info.commandPool = command_pools[i];
+      alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+      alloc_info.commandBufferCount = 1;
+      if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffers[i]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate secondary command buffer!");
+      }
+    }
+
+    threads.reserve(thread_count);
+    for (uint32_t thread = 0; thread < thread_count; ++thread)
+      threads.emplace_back(&ParallelRecorder::run_worker, this, thread);
+  } catch (...) {
+    stop();
+    throw;
+  }
+}
+
+ParallelRecorder::~ParallelRecorder()
+{
+  stop();
+}
+
+void ParallelRecorder::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  job_ready.notify_all();
+  for (auto& thread : threads)
+    thread.join();
+  threads.clear();
+
+  // destroying a pool frees its command buffers
+  for (VkCommandPool command_pool : command_pools)
+    vkDestroyCommandPool(device, command_pool, nullptr);
+  command_pools.clear();
+}
+
+const std::vector<VkCommandBuffer>& ParallelRecorder::record(uint32_t frame,
+                                                             VkRenderPass render_pass,
+                                                             VkFramebuffer framebuffer,
+                                                             VkFormat color_format,
+                                                             uint32_t item_count,
+                                                             const RecordFunction& record_slice)
+{
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    job = {frame, render_pass, framebuffer, color_format, item_count, &record_slice};
+    pending = thread_count;
+    ++generation;
+    job_ready.notify_all();
+    job_done.wait(lock, [this]() { return pending == 0; });
+  }
+
+  for (auto& error : errors) {
+    if (error) {
+      std::exception_ptr first_error = error;
+      for (auto& e : errors)
+        e = nullptr;
+      std::rethrow_exception(first_error);
+    }
+  }
+
+  executable_command_buffers.clear();
+  for (uint32_t thread = 0; thread < thread_count; ++thread) {
+    if (slice_counts[thread] > 0)
+      executable_command_buffers.push_back(command_buffers[frame * thread_count + thread]);
+  }
+
+  return executable_command_buffers;
+}
+
+void ParallelRecorder::run_worker(uint32_t thread)
+{
+  PROFILE_THREAD_NAME("parallel recorder");
+  uint64_t seen_generation = 0;
+  for (;;) {
+    Job current_job;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      job_ready.wait(lock, [this, seen_generation]() { return stopping || generation != seen_generation; });
+      if (stopping)
+        return;
+
+      seen_generation = generation;
+      current_job = job;
+    }
+
+    std::exception_ptr error;
+    try {
+      record_slice(thread, current_job);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    errors[thread] = error;
+    if (--pending == 0)
+      job_done.notify_one();
+  }
+}
+
+void ParallelRecorder::record_slice(uint32_t thread, const Job& job)
+{
+  PROFILE_ZONE("record slice");
+  // the first item_count % thread_count threads take one extra item
+  const uint32_t base = job.item_count / thread_count;
+  const uint32_t remainder = job.item_count % thread_count;
+  const uint32_t count = base + (thread < remainder ? 1 : 0);
+  const uint32_t first = thread * base + std::min(thread, remainder);
+
+  slice_counts[thread] = count;
+  if (count == 0)
+    return;
+
+  const std::size_t index = static_cast<std::size_t>(job.frame) * thread_count + thread;
+  if (vkResetCommandPool(device, command_pools[index], 0) != VK_SUCCESS) {
+    throw std::runtime_error("failed to reset recording command pool!");
+  }
+
+  VkCommandBufferInheritanceRenderingInfo rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachmentFormats = &job.color_format;
+  rendering_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkCommandBufferInheritanceInfo inheritance_info{};
+  inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance_info.pNext = job.render_pass == VK_NULL_HANDLE ? &rendering_info : nullptr;
+  inheritance_info.renderPass = job.render_pass;
+  inheritance_info.subpass = 0;
+  inheritance_info.framebuffer = job.framebuffer;
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  begin_info.pInheritanceInfo = &inheritance_info;
+
+  VkCommandBuffer command_buffer = command_buffers[index];
+  if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+    throw std::runtime_error("failed to begin recording secondary command buffer!");
+  }
+
+  (*job.record_slice)(command_buffer, first, count);
+
+  if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record secondary command buffer!");
+  }
+}
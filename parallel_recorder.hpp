@@ -0,0 +1,80 @@
+#ifndef PARALLEL_RECORDER_HPP
+#define PARALLEL_RECORDER_HPP
+
+#include "vulkan/vulkan_core.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! records slices of a draw list into secondary command buffers on
+//! worker threads
+//!
+//! Every worker owns one command pool per frame in flight, so no pool
+//! is ever touched by two threads and a frame only resets the pools it
+//! owns after its fence has been waited on.
+class ParallelRecorder
+{
+public:
+  //! records the draws [first, first + count) into a secondary
+  //! command buffer that continues the render pass
+  using RecordFunction = std::function<void(VkCommandBuffer command_buffer, uint32_t first, uint32_t count)>;
+
+  ParallelRecorder(VkDevice device, uint32_t queue_family_index, uint32_t thread_count, uint32_t frames_in_flight);
+  ParallelRecorder(const ParallelRecorder&) = delete;
+  ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+  ~ParallelRecorder();
+
+  //! splits [0, item_count) evenly across the workers and blocks until
+  //! all of them are recorded, the returned buffers stay valid until
+  //! \p frame is recorded again
+  //!
+  //! With a null \p render_pass the buffers continue dynamic rendering
+  //! into a single \p color_format attachment instead.
+  const std::vector<VkCommandBuffer>& record(uint32_t frame,
+                                             VkRenderPass render_pass,
+                                             VkFramebuffer framebuffer,
+                                             VkFormat color_format,
+                                             uint32_t item_count,
+                                             const RecordFunction& record_slice);
+
+private:
+  struct Job
+  {
+    uint32_t frame;
+    VkRenderPass render_pass;
+    VkFramebuffer framebuffer;
+    VkFormat color_format;
+    uint32_t item_count;
+    const RecordFunction* record_slice;
+  };
+
+  void run_worker(uint32_t thread);
+  void record_slice(uint32_t thread, const Job& job);
+  void stop();
+
+  VkDevice device;
+  uint32_t thread_count;
+  //! indexed by frame * thread_count + thread
+  std::vector<VkCommandPool> command_pools;
+  std::vector<VkCommandBuffer> command_buffers;
+  //! number of draws each thread recorded for the current job
+  std::vector<uint32_t> slice_counts;
+  std::vector<VkCommandBuffer> executable_command_buffers;
+
+  std::mutex mutex;
+  std::condition_variable job_ready;
+  std::condition_variable job_done;
+  Job job{};
+  uint64_t generation = 0;
+  uint32_t pending = 0;
+  bool stopping = false;
+  std::vector<std::exception_ptr> errors;
+  std::vector<std::thread> threads;
+};
+
+#endif // PARALLEL_RECORDER_HPP
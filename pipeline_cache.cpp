@@ -0,0 +1,153 @@
+#include "pipeline_cache.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#else
+#error "OS not supported yet"
+#endif
+
+namespace {
+  bool header_matches(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+  {
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+      return false;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.headerSize >= sizeof(header) &&
+      header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+      header.vendorID == properties.vendorID &&
+      header.deviceID == properties.deviceID &&
+      std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+
+  std::vector<char> read_file(const std::filesystem::path& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+      return {};
+
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+  }
+}
+
+PipelineCache::PipelineCache(VkDevice device,
+                             const VkPhysicalDeviceProperties& properties,
+                             std::filesystem::path path) :
+    device{device}, path{std::move(path)}
+{
+  std::vector<char> data = read_file(this->path);
+  if (!data.empty() && !header_matches(data, properties)) {
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo create_info{};
+  create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  create_info.initialDataSize = data.size();
+  create_info.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(device, &create_info, nullptr, &pipeline_cache) != VK_SUCCESS) {
+    if (data.empty()) {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    // the driver rejected the stored data, start over with an empty cache
+    create_info.initialDataSize = 0;
+    create_info.pInitialData = nullptr;
+    if (vkCreatePipelineCache(device, &create_info, nullptr, &pipeline_cache) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+  } else {
+    loaded = !data.empty();
+  }
+}
+
+PipelineCache::~PipelineCache()
+{
+  vkDestroyPipelineCache(device, pipeline_cache, nullptr);
+}
+
+VkPipelineCache PipelineCache::get() const
+{
+  return pipeline_cache;
+}
+
+bool PipelineCache::loaded_from_file() const
+{
+  return loaded;
+}
+
+void PipelineCache::save() const
+{
+  std::size_t size = 0;
+  if (vkGetPipelineCacheData(device, pipeline_cache, &size, nullptr) != VK_SUCCESS) {
+    throw std::runtime_error("failed to query pipeline cache size!");
+  }
+
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device, pipeline_cache, &size, data.data()) != VK_SUCCESS) {
+    throw std::runtime_error("failed to get pipeline cache data!");
+  }
+  data.resize(size);
+
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+
+  // every process saving the shared cache writes its own temporary
+  // file in the same directory, so rename(2) stays on one file system
+  std::string temp_name = path.string() + ".XXXXXX";
+  const int fd = mkstemp(temp_name.data());
+  if (fd == -1) {
+    std::ostringstream oss;
+    oss << "failed to create a temporary file for pipeline cache " << path;
+    throw std::runtime_error(oss.str());
+  }
+  const std::filesystem::path temp_path{temp_name};
+
+  const char* remaining = data.data();
+  std::size_t remaining_size = data.size();
+  bool written = true;
+  while (remaining_size > 0) {
+    const ssize_t result = write(fd, remaining, remaining_size);
+    if (result == -1 && errno == EINTR)
+      continue;
+    if (result <= 0) {
+      written = false;
+      break;
+    }
+    remaining += result;
+    remaining_size -= static_cast<std::size_t>(result);
+  }
+  // the data has to be on disk before the rename makes it visible,
+  // otherwise a crash may leave an empty cache behind
+  written = written && fsync(fd) == 0;
+  written = close(fd) == 0 && written;
+  if (!written) {
+    std::filesystem::remove(temp_path);
+    std::ostringstream oss;
+    oss << "failed to write pipeline cache " << temp_path;
+    throw std::runtime_error(oss.str());
+  }
+
+  // rename(2) replaces the target atomically, readers either see the
+  // old or the new cache but never a partially written one
+  try {
+    std::filesystem::rename(temp_path, path);
+  } catch (...) {
+    std::filesystem::remove(temp_path);
+    throw;
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef PIPELINE_CACHE_HPP
+#define PIPELINE_CACHE_HPP
+
+#include "vulkan/vulkan_core.h"
+
+#include <filesystem>
+
+//! VkPipelineCache which is persisted in a file
+//!
+//! The file is only used if its header matches the vendor, device
+//! and pipeline cache UUID of the current physical device, any other
+//! content is silently discarded.
+class PipelineCache
+{
+public:
+  PipelineCache(VkDevice device,
+                const VkPhysicalDeviceProperties& properties,
+                std::filesystem::path path);
+  PipelineCache(const PipelineCache&) = delete;
+  PipelineCache& operator=(const PipelineCache&) = delete;
+  ~PipelineCache();
+
+  VkPipelineCache get() const;
+  bool loaded_from_file() const;
+
+  //! writes the cache to a uniquely named temporary file which then
+  //! replaces the previous cache file atomically, so concurrent runs
+  //! sharing the file never see each other's partial writes
+  void save() const;
+
+private:
+  VkDevice device;
+  VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+  std::filesystem::path path;
+  bool loaded = false;
+};
+
+#endif // PIPELINE_CACHE_HPP
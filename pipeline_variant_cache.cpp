@@ -0,0 +1,120 @@
+#include "pipeline_variant_cache.hpp"
+
+#include <tuple>
+
+namespace {
+  template <typename T>
+  void hash_combine(std::size_t& seed, const T& value)
+  {
+    // from boost::hash_combine, spreads the bits of small enum values
+    seed ^= std::hash<T>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+  }
+
+  auto tie(const PipelineState& state)
+  {
+    return std::tie(state.vert_shader_module,
+                    state.frag_shader_module,
+                    state.render_pass,
+                    state.color_format,
+                    state.instanced,
+                    state.polygon_mode,
+                    state.samples,
+                    state.blend_enable,
+                    state.src_color_blend_factor,
+                    state.dst_color_blend_factor,
+                    state.color_blend_op,
+                    state.src_alpha_blend_factor,
+                    state.dst_alpha_blend_factor,
+                    state.alpha_blend_op,
+                    state.color_write_mask);
+  }
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+  return tie(*this) == tie(other);
+}
+
+bool PipelineState::operator!=(const PipelineState& other) const
+{
+  return !(*this == other);
+}
+
+std::size_t PipelineStateHash::operator()(const PipelineState& state) const
+{
+  std::size_t seed = 0;
+  std::apply([&seed](const auto&... fields) { (hash_combine(seed, fields), ...); }, tie(state));
+  return seed;
+}
+
+PipelineVariantCache::PipelineVariantCache(VkDevice device, BuildFunction build) :
+    device{device},
+    build{std::move(build)}
+{
+}
+
+PipelineVariantCache::~PipelineVariantCache()
+{
+  for (const auto& [state, pipeline] : pipelines)
+    vkDestroyPipeline(device, pipeline, nullptr);
+}
+
+VkPipeline PipelineVariantCache::get(const PipelineState& state)
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    const auto it = pipelines.find(state);
+    if (it != pipelines.end()) {
+      ++hit_count;
+      return it->second;
+    }
+    ++miss_count;
+  }
+
+  return insert(state, build(state));
+}
+
+VkPipeline PipelineVariantCache::insert(const PipelineState& state, VkPipeline pipeline)
+{
+  std::lock_guard<std::mutex> lock{mutex};
+  const auto [it, inserted] = pipelines.emplace(state, pipeline);
+  if (!inserted)
+    vkDestroyPipeline(device, pipeline, nullptr);
+
+  return it->second;
+}
+
+std::vector<VkPipeline> PipelineVariantCache::extract_if(const std::function<bool(const PipelineState& state)>& predicate)
+{
+  std::vector<VkPipeline> extracted;
+
+  std::lock_guard<std::mutex> lock{mutex};
+  for (auto it = pipelines.begin(); it != pipelines.end();) {
+    if (predicate(it->first)) {
+      extracted.push_back(it->second);
+      it = pipelines.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  return extracted;
+}
+
+std::size_t PipelineVariantCache::size() const
+{
+  std::lock_guard<std::mutex> lock{mutex};
+  return pipelines.size();
+}
+
+uint64_t PipelineVariantCache::hits() const
+{
+  std::lock_guard<std::mutex> lock{mutex};
+  return hit_count;
+}
+
+uint64_t PipelineVariantCache::misses() const
+{
+  std::lock_guard<std::mutex> lock{mutex};
+  return miss_count;
+}
@@ -0,0 +1,87 @@
+#ifndef PIPELINE_VARIANT_CACHE_HPP
+#define PIPELINE_VARIANT_CACHE_HPP
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//! the state which is baked into a graphics pipeline
+//!
+//! Cull mode, front face, topology and primitive restart are left out
+//! on purpose, they are dynamic state in Vulkan 1.3 and set while
+//! recording, so draws differing only in them share a pipeline.
+struct PipelineState
+{
+  VkShaderModule vert_shader_module = VK_NULL_HANDLE;
+  VkShaderModule frag_shader_module = VK_NULL_HANDLE;
+  //! VK_NULL_HANDLE for dynamic rendering
+  VkRenderPass render_pass = VK_NULL_HANDLE;
+  VkFormat color_format = VK_FORMAT_UNDEFINED;
+  //! adds the per-instance vertex binding
+  bool instanced = false;
+  VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+  VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+  VkBool32 blend_enable = VK_FALSE;
+  VkBlendFactor src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+  VkBlendFactor dst_color_blend_factor = VK_BLEND_FACTOR_ZERO;
+  VkBlendOp color_blend_op = VK_BLEND_OP_ADD;
+  VkBlendFactor src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+  VkBlendFactor dst_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+  VkBlendOp alpha_blend_op = VK_BLEND_OP_ADD;
+  VkColorComponentFlags color_write_mask =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  bool operator==(const PipelineState& other) const;
+  bool operator!=(const PipelineState& other) const;
+};
+
+struct PipelineStateHash
+{
+  std::size_t operator()(const PipelineState& state) const;
+};
+
+//! returns the pipeline of a state, building it only if no pipeline
+//! for an equal state exists yet
+//!
+//! get() may be called from several threads. A build runs without
+//! holding the lock, if two threads miss on the same state at once
+//! the pipeline built second is destroyed again.
+class PipelineVariantCache
+{
+public:
+  using BuildFunction = std::function<VkPipeline(const PipelineState& state)>;
+
+  PipelineVariantCache(VkDevice device, BuildFunction build);
+  PipelineVariantCache(const PipelineVariantCache&) = delete;
+  PipelineVariantCache& operator=(const PipelineVariantCache&) = delete;
+  ~PipelineVariantCache();
+
+  VkPipeline get(const PipelineState& state);
+  //! adds a pipeline built elsewhere, for example in the background,
+  //! the cache owns it afterwards and destroys it right away if
+  //! there already is a pipeline for \p state
+  VkPipeline insert(const PipelineState& state, VkPipeline pipeline);
+
+  //! removes the pipelines whose state matches \p predicate, the
+  //! caller owns them afterwards and destroys them once unused
+  std::vector<VkPipeline> extract_if(const std::function<bool(const PipelineState& state)>& predicate);
+
+  std::size_t size() const;
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+private:
+  VkDevice device;
+  BuildFunction build;
+  mutable std::mutex mutex;
+  std::unordered_map<PipelineState, VkPipeline, PipelineStateHash> pipelines;
+  uint64_t hit_count = 0;
+  uint64_t miss_count = 0;
+};
+
+#endif // PIPELINE_VARIANT_CACHE_HPP
@@ -0,0 +1,198 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+  uint64_t steady_nanoseconds()
+  {
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  struct Registry
+  {
+    //! calibrates the ticks of profiler::now() against the steady clock
+    const uint64_t start_ticks = profiler::now();
+    const uint64_t start_nanoseconds = steady_nanoseconds();
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<profiler::ThreadBuffer>> buffers;
+    //! indexed by thread id
+    std::vector<std::string> thread_names;
+  };
+
+  Registry& registry()
+  {
+    // never destroyed, threads may still record while statics are torn down
+    static Registry* registry = new Registry;
+    return *registry;
+  }
+
+  // created at startup, the longer the calibration spans the more
+  // precise it gets
+  [[maybe_unused]] const Registry& startup_registry = registry();
+
+  void write_json_string(std::ostream& out, std::string_view text)
+  {
+    static constexpr char hex_digits[] = "0123456789abcdef";
+    out << '"';
+    for (const char c : text) {
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        out << "\\u00" << hex_digits[(c >> 4) & 0xf] << hex_digits[c & 0xf];
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+  }
+}
+
+profiler::ThreadBuffer::ThreadBuffer(uint32_t id) : thread_id{id}
+{
+}
+
+uint32_t profiler::ThreadBuffer::id() const
+{
+  return thread_id;
+}
+
+uint64_t profiler::ThreadBuffer::size() const
+{
+  return zone_count.load(std::memory_order_acquire);
+}
+
+std::vector<profiler::Zone> profiler::ThreadBuffer::snapshot() const
+{
+  const uint64_t end = zone_count.load(std::memory_order_acquire);
+  if (end == 0)
+    return {};
+
+  const uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+  std::vector<Zone> zones;
+  zones.reserve(static_cast<std::size_t>(end - begin));
+  for (uint64_t index = begin; index < end; ++index)
+    zones.push_back((*ring)[index & (RING_SIZE - 1)]);
+
+  // the owning thread may have kept appending, the slots it reused
+  // since hold zones newer than the ones copied from them
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t current = zone_count.load(std::memory_order_relaxed);
+  if (current - begin > RING_SIZE) {
+    const auto torn = static_cast<std::size_t>(std::min(current - begin - RING_SIZE, end - begin));
+    zones.erase(zones.begin(), zones.begin() + static_cast<std::ptrdiff_t>(torn));
+  }
+
+  return zones;
+}
+
+uint64_t profiler::ThreadBuffer::overwritten_zones() const
+{
+  const uint64_t count = zone_count.load(std::memory_order_relaxed);
+  return count > RING_SIZE ? count - RING_SIZE : 0;
+}
+
+void profiler::ThreadBuffer::allocate_ring()
+{
+  // the ring is only read after a zone in it has been published
+  ring = std::make_unique<std::array<Zone, RING_SIZE>>();
+}
+
+profiler::ThreadBuffer* profiler::register_thread()
+{
+  auto& r = registry();
+  std::lock_guard lock{r.mutex};
+  const auto id = static_cast<uint32_t>(r.buffers.size());
+  r.buffers.push_back(std::make_unique<ThreadBuffer>(id));
+  r.thread_names.emplace_back("thread " + std::to_string(id));
+  return r.buffers.back().get();
+}
+
+void profiler::set_thread_name(std::string name)
+{
+  const uint32_t id = thread_buffer().id();
+  auto& r = registry();
+  std::lock_guard lock{r.mutex};
+  r.thread_names[id] = std::move(name);
+}
+
+void profiler::write_chrome_trace(std::ostream& out)
+{
+  auto& r = registry();
+  std::lock_guard lock{r.mutex};
+
+  std::vector<std::vector<Zone>> zones;
+  zones.reserve(r.buffers.size());
+  uint64_t start = std::numeric_limits<uint64_t>::max();
+  for (const auto& buffer : r.buffers) {
+    zones.push_back(buffer->snapshot());
+    for (const auto& zone : zones.back())
+      start = std::min(start, zone.begin);
+  }
+
+  const uint64_t elapsed_ticks = profiler::now() - r.start_ticks;
+  const uint64_t elapsed_nanoseconds = steady_nanoseconds() - r.start_nanoseconds;
+  const double microseconds_per_tick = elapsed_ticks != 0 && elapsed_nanoseconds != 0
+    ? static_cast<double>(elapsed_nanoseconds) / static_cast<double>(elapsed_ticks) / 1000.0
+    : 0.001;
+  const auto to_microseconds = [microseconds_per_tick](uint64_t ticks) {
+    return static_cast<double>(ticks) * microseconds_per_tick;
+  };
+
+  const auto flags = out.flags();
+  out << std::fixed;
+  out.precision(3);
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for (std::size_t b = 0; b < r.buffers.size(); ++b) {
+    const auto& buffer = *r.buffers[b];
+    out << (first ? "\n" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer.id()
+        << R"(,"args":{"name":)";
+    write_json_string(out, r.thread_names[buffer.id()]);
+    out << "}}";
+    first = false;
+
+    for (const auto& zone : zones[b]) {
+      out << ",\n{\"name\":";
+      write_json_string(out, zone.name);
+      out << R"(,"ph":"X","ts":)" << to_microseconds(zone.begin - start)
+          << ",\"dur\":" << to_microseconds(zone.end - zone.begin)
+          << ",\"pid\":1,\"tid\":" << buffer.id() << '}';
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  out.flags(flags);
+}
+
+void profiler::write_chrome_trace(const std::filesystem::path& path)
+{
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to create trace \"" + path.string() + "\"!");
+  }
+
+  write_chrome_trace(file);
+  if (!file) {
+    throw std::runtime_error("failed to write trace \"" + path.string() + "\"!");
+  }
+}
+
+uint64_t profiler::overwritten_zones()
+{
+  auto& r = registry();
+  std::lock_guard lock{r.mutex};
+  uint64_t overwritten = 0;
+  for (const auto& buffer : r.buffers)
+    overwritten += buffer->overwritten_zones();
+  return overwritten;
+}
@@ -0,0 +1,148 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+//! Scoped zones record when a scope was entered and left. Every thread
+//! appends to its own buffer without locks or read-modify-write
+//! atomics, the buffers are only merged when the trace is written.
+namespace profiler {
+  //! zones each thread keeps, once its ring is full the oldest zones
+  //! are overwritten, so a trace shows the end of a run
+  constexpr std::size_t RING_SIZE = std::size_t{1} << 16;
+  static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "the ring size has to be a power of two");
+
+  //! nothing is recorded and no ring is allocated until it is set
+  inline std::atomic<bool> recording_enabled{false};
+
+  inline void set_enabled(bool enabled)
+  {
+    recording_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  struct Zone
+  {
+    //! has to outlive the profiler, usually a string literal
+    const char* name;
+    //! ticks of now()
+    uint64_t begin;
+    uint64_t end;
+  };
+
+  //! zones of one thread, only that thread appends to it
+  class ThreadBuffer
+  {
+  public:
+    explicit ThreadBuffer(uint32_t id);
+    ThreadBuffer(const ThreadBuffer&) = delete;
+    ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+    void append(const Zone& zone)
+    {
+      const uint64_t index = zone_count.load(std::memory_order_relaxed);
+      if (!ring)
+        allocate_ring();
+
+      (*ring)[index & (RING_SIZE - 1)] = zone;
+      // publishes the zone to the thread writing the trace
+      zone_count.store(index + 1, std::memory_order_release);
+    }
+
+    uint32_t id() const;
+    //! zones appended so far, including the overwritten ones
+    uint64_t size() const;
+    //! the zones still in the ring, oldest first, zones overwritten
+    //! while copying are left out
+    std::vector<Zone> snapshot() const;
+    uint64_t overwritten_zones() const;
+
+  private:
+    void allocate_ring();
+
+    const uint32_t thread_id;
+    std::atomic<uint64_t> zone_count{0};
+    //! allocated by the owning thread before its first zone is published
+    std::unique_ptr<std::array<Zone, RING_SIZE>> ring;
+  };
+
+  //! buffers live until the process exits, so the zones of finished
+  //! threads still end up in the trace
+  ThreadBuffer* register_thread();
+
+  inline ThreadBuffer& thread_buffer()
+  {
+    thread_local ThreadBuffer* buffer = register_thread();
+    return *buffer;
+  }
+
+  //! the time stamp counter where there is one, it takes a fraction of
+  //! the time the steady clock does and is converted when the trace is
+  //! written
+  inline uint64_t now()
+  {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  class ScopedZone
+  {
+  public:
+    //! a begin of 0 marks a zone entered while recording was disabled
+    explicit ScopedZone(const char* name) :
+        name{name}, begin{recording_enabled.load(std::memory_order_relaxed) ? now() : 0} {}
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+    ~ScopedZone()
+    {
+      if (begin != 0)
+        thread_buffer().append({name, begin, now()});
+    }
+
+  private:
+    const char* name;
+    uint64_t begin;
+  };
+
+  //! names the calling thread in the trace
+  void set_thread_name(std::string name);
+
+  //! Chrome trace event format, readable by chrome://tracing and
+  //! Perfetto, times are relative to the earliest zone
+  void write_chrome_trace(std::ostream& out);
+  void write_chrome_trace(const std::filesystem::path& path);
+
+  //! zones no longer in the rings, summed over all threads
+  uint64_t overwritten_zones();
+}
+
+#define PROFILE_ZONE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_IMPL(a, b)
+
+//! PROFILE_ZONE times the enclosing scope, \p name has to be a string
+//! literal. PROFILE_THREAD_NAME names the calling thread.
+#if defined(PROFILING)
+#define PROFILE_ZONE(name) profiler::ScopedZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__){name}
+#define PROFILE_THREAD_NAME(name) profiler::set_thread_name(name)
+#else
+#define PROFILE_ZONE(name) static_cast<void>(0)
+#define PROFILE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,73 @@
+#include "ring_allocator.hpp"
+
+#include <stdexcept>
+
+RingAllocator::RingAllocator(std::uint64_t capacity)
+  : ring_capacity{capacity}
+{
+  if (capacity == 0) {
+    throw std::invalid_argument("ring capacity must not be zero!");
+  }
+}
+
+std::optional<std::uint64_t> RingAllocator::allocate(std::uint64_t size, std::uint64_t alignment)
+{
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    throw std::invalid_argument("alignment must be a power of two!");
+  }
+
+  std::uint64_t offset = (head + alignment - 1) & ~(alignment - 1);
+  if (offset > ring_capacity || size > ring_capacity - offset) {
+    // skip the rest of the ring, the skipped bytes are released with
+    // the current frame
+    offset = 0;
+  }
+
+  const std::uint64_t consumed = offset >= head ? offset - head + size : ring_capacity - head + size;
+  if (consumed > ring_capacity - used_size)
+    return std::nullopt;
+
+  used_size += consumed;
+  open_size += consumed;
+  head = (offset + size) % ring_capacity;
+  return offset;
+}
+
+void RingAllocator::end_frame(std::uint64_t value)
+{
+  if (open_size == 0)
+    return;
+
+  frames.push_back({value, open_size});
+  open_size = 0;
+}
+
+void RingAllocator::release(std::uint64_t completed_value)
+{
+  while (!frames.empty() && frames.front().value <= completed_value) {
+    used_size -= frames.front().size;
+    frames.pop_front();
+  }
+
+  // start over at the beginning to keep allocations from wrapping
+  if (used_size == 0)
+    head = 0;
+}
+
+void RingAllocator::reset()
+{
+  frames.clear();
+  head = 0;
+  used_size = 0;
+  open_size = 0;
+}
+
+std::uint64_t RingAllocator::capacity() const
+{
+  return ring_capacity;
+}
+
+std::uint64_t RingAllocator::used() const
+{
+  return used_size;
+}
@@ -0,0 +1,46 @@
+#ifndef RING_ALLOCATOR_HPP
+#define RING_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+//! hands out offsets into a ring of \p capacity bytes, it never
+//! touches any memory itself
+//!
+//! Allocations are not freed one by one. end_frame() tags everything
+//! allocated since the previous call with a timeline value and
+//! release() reclaims the frames whose value has been reached, oldest
+//! first.
+class RingAllocator
+{
+public:
+  explicit RingAllocator(std::uint64_t capacity);
+
+  //! \p alignment has to be a power of two, an allocation never wraps
+  //! around the end of the ring
+  std::optional<std::uint64_t> allocate(std::uint64_t size, std::uint64_t alignment);
+  void end_frame(std::uint64_t value);
+  void release(std::uint64_t completed_value);
+  //! frees everything, tagged or not
+  void reset();
+
+  std::uint64_t capacity() const;
+  //! including alignment padding and space skipped at the end
+  std::uint64_t used() const;
+
+private:
+  struct Frame
+  {
+    std::uint64_t value;
+    std::uint64_t size;
+  };
+
+  std::uint64_t ring_capacity;
+  std::uint64_t head = 0;
+  std::uint64_t used_size = 0;
+  std::uint64_t open_size = 0;
+  std::deque<Frame> frames;
+};
+
+#endif // RING_ALLOCATOR_HPP
@@ -0,0 +1,58 @@
+#include "rolling_statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+RollingStatistics::RollingStatistics(std::size_t capacity) : capacity{capacity}
+{
+  if (capacity == 0) {
+    throw std::invalid_argument("rolling statistics capacity must not be zero");
+  }
+
+  samples.reserve(capacity);
+}
+
+void RollingStatistics::add(double sample)
+{
+  if (!full) {
+    samples.push_back(sample);
+    full = samples.size() == capacity;
+    next = samples.size() % capacity;
+  } else {
+    samples[next] = sample;
+    next = (next + 1) % capacity;
+  }
+}
+
+void RollingStatistics::clear()
+{
+  samples.clear();
+  next = 0;
+  full = false;
+}
+
+std::size_t RollingStatistics::size() const
+{
+  return samples.size();
+}
+
+RollingStatistics::Summary RollingStatistics::summary() const
+{
+  if (samples.empty()) {
+    return {0, 0.0, 0.0, 0.0, 0.0};
+  }
+
+  std::vector<double> sorted{samples};
+  // nearest rank percentile
+  const auto rank = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(sorted.size())));
+  const auto p99 = std::next(sorted.begin(), static_cast<std::ptrdiff_t>(rank - 1));
+  std::nth_element(sorted.begin(), p99, sorted.end());
+
+  const auto [min, max] = std::minmax_element(samples.begin(), samples.end());
+  const double sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+
+  return {samples.size(), *min, sum / static_cast<double>(samples.size()), *p99, *max};
+}
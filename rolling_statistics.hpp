@@ -0,0 +1,35 @@
+#ifndef ROLLING_STATISTICS_HPP
+#define ROLLING_STATISTICS_HPP
+
+#include <cstddef>
+#include <vector>
+
+//! keeps the most recent samples in a fixed size window and
+//! summarizes them on demand
+class RollingStatistics
+{
+public:
+  struct Summary
+  {
+    std::size_t count;
+    double min;
+    double avg;
+    double p99;
+    double max;
+  };
+
+  explicit RollingStatistics(std::size_t capacity);
+
+  void add(double sample);
+  void clear();
+  std::size_t size() const;
+  Summary summary() const;
+
+private:
+  std::size_t capacity;
+  std::vector<double> samples;
+  std::size_t next = 0;
+  bool full = false;
+};
+
+#endif // ROLLING_STATISTICS_HPP
@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+//! bounded lock-free queue between exactly one producer thread and one
+//! consumer thread
+//!
+//! Each side only writes its own index, the other side reads it with
+//! acquire semantics. The indices run freely and are masked on access,
+//! which is why \p Capacity has to be a power of two.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  //! producer only, returns false if the queue is full
+  bool try_push(const T& value)
+  {
+    const std::size_t write = write_index.load(std::memory_order_relaxed);
+    if (write - read_index.load(std::memory_order_acquire) == Capacity)
+      return false;
+
+    items[write & (Capacity - 1)] = value;
+    write_index.store(write + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! consumer only
+  std::optional<T> try_pop()
+  {
+    const std::size_t read = read_index.load(std::memory_order_relaxed);
+    if (read == write_index.load(std::memory_order_acquire))
+      return std::nullopt;
+
+    T value = items[read & (Capacity - 1)];
+    read_index.store(read + 1, std::memory_order_release);
+    return value;
+  }
+
+  //! exact only when called by one of the two sides
+  bool empty() const
+  {
+    return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+  }
+
+private:
+  // on separate cache lines so the two sides do not invalidate each
+  // other's index on every operation
+  alignas(64) std::atomic<std::size_t> write_index{0};
+  alignas(64) std::atomic<std::size_t> read_index{0};
+  std::array<T, Capacity> items{};
+};
+
+#endif // SPSC_QUEUE_HPP
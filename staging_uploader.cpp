@@ -0,0 +1,246 @@
+#include "staging_uploader.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  VkCommandPool create_command_pool(VkDevice device, uint32_t queue_family_index)
+  {
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = queue_family_index;
+
+    VkCommandPool command_pool;
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload command pool!");
+    }
+
+    return command_pool;
+  }
+}
+
+StagingUploader::StagingUploader(VkDevice device,
+                                 GpuAllocator& allocator,
+                                 uint32_t transfer_queue_family_index,
+                                 VkQueue transfer_queue,
+                                 uint32_t graphics_queue_family_index,
+                                 VkQueue graphics_queue) :
+    device{device},
+    allocator{allocator},
+    transfer_queue_family_index{transfer_queue_family_index},
+    transfer_queue{transfer_queue},
+    graphics_queue_family_index{graphics_queue_family_index},
+    graphics_queue{graphics_queue}
+{
+  transfer_command_pool = create_command_pool(device, transfer_queue_family_index);
+  if (transfer_queue_family_index != graphics_queue_family_index) {
+    try {
+      graphics_command_pool = create_command_pool(device, graphics_queue_family_index);
+    } catch (...) {
+      vkDestroyCommandPool(device, transfer_command_pool, nullptr);
+      throw;
+    }
+  }
+}
+
+StagingUploader::~StagingUploader()
+{
+  vkDestroyCommandPool(device, graphics_command_pool, nullptr);
+  vkDestroyCommandPool(device, transfer_command_pool, nullptr);
+}
+
+void StagingUploader::enqueue(VkBuffer dst_buffer,
+                              VkDeviceSize dst_offset,
+                              const void* data,
+                              VkDeviceSize size,
+                              VkPipelineStageFlags dst_stage,
+                              VkAccessFlags dst_access)
+{
+  // keep every source region aligned for vkCmdCopyBuffer friendly access
+  constexpr VkDeviceSize alignment = 16;
+  const VkDeviceSize src_offset = (staging_data.size() + alignment - 1) & ~(alignment - 1);
+
+  staging_data.resize(static_cast<std::size_t>(src_offset + size));
+  std::memcpy(staging_data.data() + src_offset, data, static_cast<std::size_t>(size));
+  uploads.push_back({dst_buffer, dst_offset, src_offset, size, dst_stage, dst_access});
+}
+
+VkCommandBuffer StagingUploader::begin_command_buffer(VkCommandPool command_pool)
+{
+  VkCommandBufferAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  alloc_info.commandPool = command_pool;
+  alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  alloc_info.commandBufferCount = 1;
+
+  VkCommandBuffer command_buffer;
+  if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate upload command buffer!");
+  }
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+    vkFreeCommandBuffers(device, command_pool, 1, &command_buffer);
+    throw std::runtime_error("failed to begin recording upload command buffer!");
+  }
+
+  return command_buffer;
+}
+
+void StagingUploader::flush()
+{
+  if (uploads.empty())
+    return;
+
+  VkBuffer staging_buffer = VK_NULL_HANDLE;
+  GpuAllocation staging_allocation;
+  VkSemaphore ownership_semaphore = VK_NULL_HANDLE;
+  VkFence fence = VK_NULL_HANDLE;
+  VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+  VkCommandBuffer graphics_command_buffer = VK_NULL_HANDLE;
+  const auto cleanup = [&]() {
+    vkDestroyFence(device, fence, nullptr);
+    vkDestroySemaphore(device, ownership_semaphore, nullptr);
+    vkDestroyBuffer(device, staging_buffer, nullptr);
+    allocator.free(staging_allocation);
+    if (transfer_command_buffer != VK_NULL_HANDLE)
+      vkFreeCommandBuffers(device, transfer_command_pool, 1, &transfer_command_buffer);
+    if (graphics_command_buffer != VK_NULL_HANDLE)
+      vkFreeCommandBuffers(device, graphics_command_pool, 1, &graphics_command_buffer);
+  };
+
+  try {
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = staging_data.size();
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &staging_buffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create staging buffer!");
+    }
+
+    staging_allocation = allocator.allocate_buffer_memory(staging_buffer,
+                                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::memcpy(staging_allocation.mapped, staging_data.data(), staging_data.size());
+
+    const bool transfer_ownership = transfer_queue_family_index != graphics_queue_family_index;
+
+    std::vector<VkBufferMemoryBarrier> release_barriers;
+    std::vector<VkBufferMemoryBarrier> acquire_barriers;
+    VkPipelineStageFlags dst_stages = 0;
+    for (const auto& upload : uploads) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.buffer = upload.dst_buffer;
+      barrier.offset = upload.dst_offset;
+      barrier.size = upload.size;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = upload.dst_access;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      dst_stages |= upload.dst_stage;
+
+      if (transfer_ownership) {
+        // the release half ignores dstAccessMask, the acquire half
+        // ignores srcAccessMask
+        barrier.srcQueueFamilyIndex = transfer_queue_family_index;
+        barrier.dstQueueFamilyIndex = graphics_queue_family_index;
+        VkBufferMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        release_barriers.push_back(release);
+        barrier.srcAccessMask = 0;
+        acquire_barriers.push_back(barrier);
+      } else {
+        release_barriers.push_back(barrier);
+      }
+    }
+
+    transfer_command_buffer = begin_command_buffer(transfer_command_pool);
+    for (const auto& upload : uploads) {
+      VkBufferCopy region{};
+      region.srcOffset = upload.src_offset;
+      region.dstOffset = upload.dst_offset;
+      region.size = upload.size;
+      vkCmdCopyBuffer(transfer_command_buffer, staging_buffer, upload.dst_buffer, 1, &region);
+    }
+    const VkPipelineStageFlags release_dst_stages =
+      transfer_ownership ? VkPipelineStageFlags{VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT} : dst_stages;
+    vkCmdPipelineBarrier(transfer_command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         release_dst_stages,
+                         0,
+                         0, nullptr,
+                         static_cast<uint32_t>(release_barriers.size()), release_barriers.data(),
+                         0, nullptr);
+    if (vkEndCommandBuffer(transfer_command_buffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to record upload command buffer!");
+    }
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload fence!");
+    }
+
+    VkSubmitInfo transfer_submit{};
+    transfer_submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transfer_submit.commandBufferCount = 1;
+    transfer_submit.pCommandBuffers = &transfer_command_buffer;
+
+    if (!transfer_ownership) {
+      if (vkQueueSubmit(transfer_queue, 1, &transfer_submit, fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit uploads!");
+      }
+    } else {
+      VkSemaphoreCreateInfo semaphore_info{};
+      semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      if (vkCreateSemaphore(device, &semaphore_info, nullptr, &ownership_semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload semaphore!");
+      }
+
+      transfer_submit.signalSemaphoreCount = 1;
+      transfer_submit.pSignalSemaphores = &ownership_semaphore;
+      if (vkQueueSubmit(transfer_queue, 1, &transfer_submit, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit uploads!");
+      }
+
+      graphics_command_buffer = begin_command_buffer(graphics_command_pool);
+      vkCmdPipelineBarrier(graphics_command_buffer,
+                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           dst_stages,
+                           0,
+                           0, nullptr,
+                           static_cast<uint32_t>(acquire_barriers.size()), acquire_barriers.data(),
+                           0, nullptr);
+      if (vkEndCommandBuffer(graphics_command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record ownership command buffer!");
+      }
+
+      VkSubmitInfo graphics_submit{};
+      graphics_submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      graphics_submit.waitSemaphoreCount = 1;
+      graphics_submit.pWaitSemaphores = &ownership_semaphore;
+      graphics_submit.pWaitDstStageMask = &dst_stages;
+      graphics_submit.commandBufferCount = 1;
+      graphics_submit.pCommandBuffers = &graphics_command_buffer;
+      if (vkQueueSubmit(graphics_queue, 1, &graphics_submit, fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit ownership transfer!");
+      }
+    }
+
+    vkWaitForFences(device, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+  } catch (...) {
+    // parts of the upload may already execute on the GPU
+    vkDeviceWaitIdle(device);
+    cleanup();
+    throw;
+  }
+
+  cleanup();
+  staging_data.clear();
+  uploads.clear();
+}
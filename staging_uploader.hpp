@@ -0,0 +1,68 @@
+#ifndef STAGING_UPLOADER_HPP
+#define STAGING_UPLOADER_HPP
+
+#include "gpu_allocator.hpp"
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstdint>
+#include <vector>
+
+//! copies data into device local buffers through a host visible
+//! staging buffer
+//!
+//! Uploads are collected and submitted together by flush(). If the
+//! transfer queue belongs to another queue family than the graphics
+//! queue, the destination buffers are released by the transfer queue
+//! and acquired by the graphics queue afterwards.
+class StagingUploader
+{
+public:
+  StagingUploader(VkDevice device,
+                  GpuAllocator& allocator,
+                  uint32_t transfer_queue_family_index,
+                  VkQueue transfer_queue,
+                  uint32_t graphics_queue_family_index,
+                  VkQueue graphics_queue);
+  StagingUploader(const StagingUploader&) = delete;
+  StagingUploader& operator=(const StagingUploader&) = delete;
+  ~StagingUploader();
+
+  //! \p data is copied immediately, \p dst_stage and \p dst_access
+  //! describe the first use of the buffer on the graphics queue
+  void enqueue(VkBuffer dst_buffer,
+               VkDeviceSize dst_offset,
+               const void* data,
+               VkDeviceSize size,
+               VkPipelineStageFlags dst_stage,
+               VkAccessFlags dst_access);
+
+  //! submits all pending uploads at once and waits for them
+  void flush();
+
+private:
+  struct Upload
+  {
+    VkBuffer dst_buffer;
+    VkDeviceSize dst_offset;
+    VkDeviceSize src_offset;
+    VkDeviceSize size;
+    VkPipelineStageFlags dst_stage;
+    VkAccessFlags dst_access;
+  };
+
+  VkCommandBuffer begin_command_buffer(VkCommandPool command_pool);
+
+  VkDevice device;
+  GpuAllocator& allocator;
+  uint32_t transfer_queue_family_index;
+  VkQueue transfer_queue;
+  uint32_t graphics_queue_family_index;
+  VkQueue graphics_queue;
+  VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+  VkCommandPool graphics_command_pool = VK_NULL_HANDLE;
+  std::vector<unsigned char> staging_data;
+  std::vector<Upload> uploads;
+};
+
+#endif // STAGING_UPLOADER_HPP
@@ -0,0 +1,215 @@
+#include "suballocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+  std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+  {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  bool is_power_of_two(std::uint64_t value)
+  {
+    return value != 0 && (value & (value - 1)) == 0;
+  }
+
+  std::uint64_t round_down_to_power_of_two(std::uint64_t value)
+  {
+    std::uint64_t result = 1;
+    while (result <= value / 2) {
+      result *= 2;
+    }
+
+    return result;
+  }
+}
+
+double SuballocatorStatistics::fragmentation() const
+{
+  const std::uint64_t free = capacity - used;
+  if (free == 0)
+    return 0.0;
+
+  return 1.0 - static_cast<double>(largest_free_region) / static_cast<double>(free);
+}
+
+FreeListSuballocator::FreeListSuballocator(std::uint64_t capacity) : capacity{capacity}
+{
+  if (capacity == 0) {
+    throw std::invalid_argument("suballocator capacity must not be zero");
+  }
+
+  free_regions.emplace(0, capacity);
+}
+
+std::optional<std::uint64_t> FreeListSuballocator::allocate(std::uint64_t size, std::uint64_t alignment)
+{
+  if (size == 0 || !is_power_of_two(alignment)) {
+    throw std::invalid_argument("invalid allocation size or alignment");
+  }
+
+  for (auto region = free_regions.begin(); region != free_regions.end(); ++region) {
+    const auto [region_offset, region_size] = *region;
+    const std::uint64_t offset = align_up(region_offset, alignment);
+    const std::uint64_t region_end = region_offset + region_size;
+    if (offset >= region_end || region_end - offset < size)
+      continue;
+
+    free_regions.erase(region);
+    if (offset > region_offset)
+      free_regions.emplace(region_offset, offset - region_offset);
+    if (offset + size < region_end)
+      free_regions.emplace(offset + size, region_end - (offset + size));
+
+    allocations.emplace(offset, size);
+    used += size;
+    return offset;
+  }
+
+  return std::nullopt;
+}
+
+void FreeListSuballocator::free(std::uint64_t offset)
+{
+  const auto allocation = allocations.find(offset);
+  if (allocation == allocations.end()) {
+    throw std::invalid_argument("offset was not allocated");
+  }
+
+  std::uint64_t size = allocation->second;
+  allocations.erase(allocation);
+  used -= size;
+
+  auto next = free_regions.lower_bound(offset);
+  if (next != free_regions.end() && next->first == offset + size) {
+    size += next->second;
+    next = free_regions.erase(next);
+  }
+
+  if (next != free_regions.begin()) {
+    const auto previous = std::prev(next);
+    if (previous->first + previous->second == offset) {
+      previous->second += size;
+      return;
+    }
+  }
+
+  free_regions.emplace_hint(next, offset, size);
+}
+
+SuballocatorStatistics FreeListSuballocator::statistics() const
+{
+  std::uint64_t largest_free_region = 0;
+  for (const auto& [offset, size] : free_regions) {
+    largest_free_region = std::max(largest_free_region, size);
+  }
+
+  return {capacity, used, allocations.size(), free_regions.size(), largest_free_region};
+}
+
+bool FreeListSuballocator::empty() const
+{
+  return allocations.empty();
+}
+
+BuddySuballocator::BuddySuballocator(std::uint64_t capacity, std::uint64_t min_block_size) :
+    capacity{round_down_to_power_of_two(capacity)},
+    min_block_size{min_block_size}
+{
+  if (!is_power_of_two(min_block_size) || this->capacity < min_block_size) {
+    throw std::invalid_argument("invalid buddy allocator block sizes");
+  }
+
+  unsigned orders = 1;
+  while (block_size(orders - 1) < this->capacity) {
+    ++orders;
+  }
+
+  free_blocks.resize(orders);
+  free_blocks.back().insert(0);
+}
+
+std::uint64_t BuddySuballocator::block_size(unsigned order) const
+{
+  return min_block_size << order;
+}
+
+std::optional<std::uint64_t> BuddySuballocator::allocate(std::uint64_t size, std::uint64_t alignment)
+{
+  if (size == 0 || !is_power_of_two(alignment)) {
+    throw std::invalid_argument("invalid allocation size or alignment");
+  }
+
+  const std::uint64_t needed = std::max(size, alignment);
+  unsigned order = 0;
+  while (order < free_blocks.size() && block_size(order) < needed) {
+    ++order;
+  }
+
+  unsigned available = order;
+  while (available < free_blocks.size() && free_blocks[available].empty()) {
+    ++available;
+  }
+  if (available >= free_blocks.size())
+    return std::nullopt;
+
+  const auto block = free_blocks[available].begin();
+  const std::uint64_t offset = *block;
+  free_blocks[available].erase(block);
+
+  // split until the block has the requested order, the upper halves
+  // become free buddies
+  while (available > order) {
+    --available;
+    free_blocks[available].insert(offset + block_size(available));
+  }
+
+  allocations.emplace(offset, order);
+  used += block_size(order);
+  return offset;
+}
+
+void BuddySuballocator::free(std::uint64_t offset)
+{
+  const auto allocation = allocations.find(offset);
+  if (allocation == allocations.end()) {
+    throw std::invalid_argument("offset was not allocated");
+  }
+
+  unsigned order = allocation->second;
+  allocations.erase(allocation);
+  used -= block_size(order);
+
+  while (order + 1 < free_blocks.size()) {
+    const std::uint64_t buddy = offset ^ block_size(order);
+    const auto free_buddy = free_blocks[order].find(buddy);
+    if (free_buddy == free_blocks[order].end())
+      break;
+
+    free_blocks[order].erase(free_buddy);
+    offset = std::min(offset, buddy);
+    ++order;
+  }
+
+  free_blocks[order].insert(offset);
+}
+
+SuballocatorStatistics BuddySuballocator::statistics() const
+{
+  std::uint64_t free_region_count = 0;
+  std::uint64_t largest_free_region = 0;
+  for (unsigned order = 0; order < free_blocks.size(); ++order) {
+    free_region_count += free_blocks[order].size();
+    if (!free_blocks[order].empty())
+      largest_free_region = block_size(order);
+  }
+
+  return {capacity, used, allocations.size(), free_region_count, largest_free_region};
+}
+
+bool BuddySuballocator::empty() const
+{
+  return allocations.empty();
+}
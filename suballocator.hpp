@@ -0,0 +1,83 @@
+#ifndef SUBALLOCATOR_HPP
+#define SUBALLOCATOR_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+struct SuballocatorStatistics
+{
+  std::uint64_t capacity;
+  std::uint64_t used;
+  std::uint64_t allocation_count;
+  std::uint64_t free_region_count;
+  std::uint64_t largest_free_region;
+
+  //! 0 if all free space is one contiguous region, approaches 1 the
+  //! more the free space is scattered
+  double fragmentation() const;
+};
+
+//! hands out offsets into a range of \p capacity bytes, it never
+//! touches any memory itself
+class Suballocator
+{
+public:
+  virtual ~Suballocator() = default;
+
+  //! \p alignment has to be a power of two
+  virtual std::optional<std::uint64_t> allocate(std::uint64_t size, std::uint64_t alignment) = 0;
+  virtual void free(std::uint64_t offset) = 0;
+  virtual SuballocatorStatistics statistics() const = 0;
+  virtual bool empty() const = 0;
+};
+
+//! first fit over an offset ordered list of free regions, adjacent
+//! free regions are merged again on free
+class FreeListSuballocator final : public Suballocator
+{
+public:
+  explicit FreeListSuballocator(std::uint64_t capacity);
+
+  std::optional<std::uint64_t> allocate(std::uint64_t size, std::uint64_t alignment) override;
+  void free(std::uint64_t offset) override;
+  SuballocatorStatistics statistics() const override;
+  bool empty() const override;
+
+private:
+  std::uint64_t capacity;
+  std::uint64_t used = 0;
+  //! offset -> size
+  std::map<std::uint64_t, std::uint64_t> free_regions;
+  std::unordered_map<std::uint64_t, std::uint64_t> allocations;
+};
+
+//! binary buddy allocator, every allocation is rounded up to a power
+//! of two which keeps it naturally aligned
+class BuddySuballocator final : public Suballocator
+{
+public:
+  //! \p capacity is rounded down to a power of two
+  explicit BuddySuballocator(std::uint64_t capacity, std::uint64_t min_block_size = 256);
+
+  std::optional<std::uint64_t> allocate(std::uint64_t size, std::uint64_t alignment) override;
+  void free(std::uint64_t offset) override;
+  SuballocatorStatistics statistics() const override;
+  bool empty() const override;
+
+private:
+  std::uint64_t block_size(unsigned order) const;
+
+  std::uint64_t capacity;
+  std::uint64_t min_block_size;
+  std::uint64_t used = 0;
+  //! free block offsets per order, order 0 is min_block_size
+  std::vector<std::set<std::uint64_t>> free_blocks;
+  //! offset -> order
+  std::unordered_map<std::uint64_t, unsigned> allocations;
+};
+
+#endif // SUBALLOCATOR_HPP
@@ -0,0 +1,94 @@
+#include "asset_pack.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+  std::vector<std::byte> make_bytes(const std::string& text)
+  {
+    std::vector<std::byte> bytes;
+    for (char c : text)
+      bytes.push_back(static_cast<std::byte>(c));
+    return bytes;
+  }
+
+  std::string to_string(const AssetView& view)
+  {
+    return {reinterpret_cast<const char*>(view.data()), view.size()};
+  }
+}
+
+TEST_CASE("assets are found by name and aligned", "[asset_pack]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_asset_pack.pack";
+
+  AssetPackWriter writer;
+  writer.add("vert.spv", make_bytes("vertex"), 4);
+  writer.add("mesh.bin", make_bytes("a mesh"), 256);
+  writer.add("empty", {});
+  writer.add("texture.ktx", make_bytes("some texels"), 64);
+  writer.write(path);
+
+  {
+    AssetPack pack{path};
+    REQUIRE(pack.size() == 4);
+
+    // the index is sorted no matter in which order assets were added
+    REQUIRE(pack.name(0) == "empty");
+    REQUIRE(pack.name(3) == "vert.spv");
+
+    const auto mesh = pack.find("mesh.bin");
+    REQUIRE(mesh.has_value());
+    REQUIRE(to_string(*mesh) == "a mesh");
+    REQUIRE(reinterpret_cast<std::uintptr_t>(mesh->data()) % 256 == 0);
+
+    const auto texture = pack.find("texture.ktx");
+    REQUIRE(texture.has_value());
+    REQUIRE(to_string(*texture) == "some texels");
+    REQUIRE(reinterpret_cast<std::uintptr_t>(texture->data()) % 64 == 0);
+
+    const auto empty = pack.find("empty");
+    REQUIRE(empty.has_value());
+    REQUIRE(empty->empty());
+
+    REQUIRE_FALSE(pack.find("missing").has_value());
+    REQUIRE_FALSE(pack.find("vert").has_value());
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("writer rejects invalid assets", "[asset_pack]")
+{
+  AssetPackWriter writer;
+  REQUIRE_THROWS_AS(writer.add("a", {}, 3), std::invalid_argument);
+
+  writer.add("a", make_bytes("first"));
+  writer.add("a", make_bytes("second"));
+  REQUIRE_THROWS_AS(writer.write(std::filesystem::temp_directory_path() / "test_asset_pack_duplicate.pack"),
+                    std::invalid_argument);
+}
+
+TEST_CASE("corrupt packs are rejected", "[asset_pack]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_asset_pack_corrupt.pack";
+
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "not an asset pack, just some text that is long enough for a header";
+  }
+  REQUIRE_THROWS_AS(AssetPack{path}, std::runtime_error);
+
+  AssetPackWriter writer;
+  writer.add("asset", make_bytes("data"));
+  writer.write(path);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  REQUIRE_THROWS_AS(AssetPack{path}, std::runtime_error);
+
+  std::filesystem::remove(path);
+  REQUIRE_THROWS_AS(AssetPack{path}, std::runtime_error);
+}
@@ -0,0 +1,50 @@
+#include "file_watcher.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("written and renamed files are reported once", "[file_watcher]")
+{
+  const auto directory = std::filesystem::temp_directory_path() / "test_file_watcher";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directory(directory);
+
+  {
+    FileWatcher watcher{directory};
+    REQUIRE(watcher.poll().empty());
+
+    {
+      std::ofstream file(directory / "vert.spv");
+      file << "first";
+    }
+    {
+      std::ofstream file(directory / "vert.spv");
+      file << "second";
+    }
+    const auto written = watcher.poll();
+    REQUIRE(written.size() == 1);
+    REQUIRE(written[0] == "vert.spv");
+    REQUIRE(watcher.poll().empty());
+
+    {
+      std::ofstream file(directory / "frag.spv.tmp");
+      file << "replacement";
+    }
+    watcher.poll();
+    std::filesystem::rename(directory / "frag.spv.tmp", directory / "frag.spv");
+    const auto renamed = watcher.poll();
+    REQUIRE(renamed.size() == 1);
+    REQUIRE(renamed[0] == "frag.spv");
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("watching a missing directory throws", "[file_watcher]")
+{
+  REQUIRE_THROWS_AS(FileWatcher{std::filesystem::temp_directory_path() / "test_file_watcher_missing"},
+                    std::runtime_error);
+}
@@ -0,0 +1,51 @@
+#include "frame_limiter.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+  double steady_time()
+  {
+    return std::chrono::duration<double>{std::chrono::steady_clock::now().time_since_epoch()}.count();
+  }
+}
+
+TEST_CASE("frames are not shorter than the period", "[frame_limiter]")
+{
+  FrameLimiter limiter{200.0, steady_time};
+  REQUIRE(limiter.period() == 0.005);
+
+  limiter.wait();
+  const double start = steady_time();
+  double previous = start;
+  for (int frame = 0; frame < 10; ++frame) {
+    limiter.wait();
+    const double now = steady_time();
+    // the schedule is absolute, a late wakeup is made up by the next frame
+    REQUIRE(now - start >= (frame + 1) * limiter.period() - 0.001);
+    REQUIRE(now >= previous);
+    previous = now;
+  }
+}
+
+TEST_CASE("a late frame restarts the schedule", "[frame_limiter]")
+{
+  FrameLimiter limiter{100.0, steady_time};
+  limiter.wait();
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+  // the late frame is not waited for, the one after it gets a full period
+  const double late = steady_time();
+  limiter.wait();
+  REQUIRE(steady_time() - late < limiter.period());
+  limiter.wait();
+  REQUIRE(steady_time() - late >= limiter.period());
+}
+
+TEST_CASE("the frame rate has to be positive", "[frame_limiter]")
+{
+  REQUIRE_THROWS_AS((FrameLimiter{0.0, steady_time}), std::invalid_argument);
+}
@@ -0,0 +1,109 @@
+#include "gamepad_sampler.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  std::vector<GamepadEvent> drain(GamepadSampler& sampler)
+  {
+    std::vector<GamepadEvent> events;
+    while (const auto event = sampler.next_event())
+      events.push_back(*event);
+    return events;
+  }
+
+  GamepadState buttons(uint32_t mask)
+  {
+    GamepadState state;
+    state.buttons = mask;
+    return state;
+  }
+}
+
+TEST_CASE("simultaneous button changes are all reported", "[gamepad_sampler]")
+{
+  GamepadSampler sampler{1000.0};
+
+  sampler.update(2, 0.0, buttons(0));
+  auto events = drain(sampler);
+  REQUIRE(events.size() == 1);
+  REQUIRE(events[0].type == GamepadEvent::Type::CONNECTED);
+  REQUIRE(events[0].joystick == 2);
+
+  const uint32_t a = uint32_t{1} << GLFW_GAMEPAD_BUTTON_A;
+  const uint32_t b = uint32_t{1} << GLFW_GAMEPAD_BUTTON_B;
+  const uint32_t y = uint32_t{1} << GLFW_GAMEPAD_BUTTON_Y;
+  sampler.update(2, 0.001, buttons(a | b));
+  events = drain(sampler);
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].type == GamepadEvent::Type::BUTTON_PRESSED);
+  REQUIRE(events[0].index == GLFW_GAMEPAD_BUTTON_A);
+  REQUIRE(events[1].type == GamepadEvent::Type::BUTTON_PRESSED);
+  REQUIRE(events[1].index == GLFW_GAMEPAD_BUTTON_B);
+  REQUIRE(events[1].time == 0.001);
+
+  // held buttons are not reported again
+  sampler.update(2, 0.002, buttons(b | y));
+  events = drain(sampler);
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].type == GamepadEvent::Type::BUTTON_RELEASED);
+  REQUIRE(events[0].index == GLFW_GAMEPAD_BUTTON_A);
+  REQUIRE(events[1].type == GamepadEvent::Type::BUTTON_PRESSED);
+  REQUIRE(events[1].index == GLFW_GAMEPAD_BUTTON_Y);
+
+  sampler.disconnect(2, 0.003);
+  sampler.disconnect(2, 0.004);
+  events = drain(sampler);
+  REQUIRE(events.size() == 1);
+  REQUIRE(events[0].type == GamepadEvent::Type::DISCONNECTED);
+}
+
+TEST_CASE("axes are reported once they leave the deadband", "[gamepad_sampler]")
+{
+  GamepadSampler sampler{1000.0, 0.1f};
+  GamepadState state;
+  sampler.update(0, 0.0, state);
+  drain(sampler);
+
+  // small movements add up until they cross the deadband
+  state.axes[GLFW_GAMEPAD_AXIS_LEFT_X] = 0.06f;
+  sampler.update(0, 0.001, state);
+  REQUIRE(drain(sampler).empty());
+  state.axes[GLFW_GAMEPAD_AXIS_LEFT_X] = 0.12f;
+  state.axes[GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER] = -0.5f;
+  sampler.update(0, 0.002, state);
+  const auto events = drain(sampler);
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].type == GamepadEvent::Type::AXIS_MOVED);
+  REQUIRE(events[0].index == GLFW_GAMEPAD_AXIS_LEFT_X);
+  REQUIRE(events[0].value == 0.12f);
+  REQUIRE(events[1].index == GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER);
+
+  state.axes[GLFW_GAMEPAD_AXIS_LEFT_X] = 0.15f;
+  sampler.update(0, 0.003, state);
+  REQUIRE(drain(sampler).empty());
+}
+
+TEST_CASE("poll paces the samples", "[gamepad_sampler]")
+{
+  REQUIRE_THROWS_AS(GamepadSampler{0.0}, std::invalid_argument);
+
+  GamepadSampler sampler{100.0};
+  REQUIRE(sampler.interval() == 0.01);
+  const double first = sampler.poll(1.0);
+  REQUIRE(first > 0.0099);
+  REQUIRE(first < 0.0101);
+
+  // not due yet, the remaining time is returned
+  const double remaining = sampler.poll(1.004);
+  REQUIRE(remaining > 0.0059);
+  REQUIRE(remaining < 0.0061);
+
+  // a late poll restarts the schedule instead of catching up
+  sampler.poll(2.0);
+  const double next = sampler.poll(2.001);
+  REQUIRE(next > 0.0089);
+  REQUIRE(next < 0.0091);
+}
@@ -0,0 +1,75 @@
+#include "input_recording.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+TEST_CASE("recorded input is played back on schedule", "[input_recording]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_input_recording.bin";
+
+  {
+    InputRecorder recorder{path};
+    recorder.record_key(0.5, 65, 1);
+    recorder.record_gamepad(1.0, {123.0, 3, GamepadEvent::Type::AXIS_MOVED, 4, 0.75f});
+    recorder.record_resize(2.0, 800, 600);
+    recorder.flush();
+  }
+
+  InputPlayback playback{path};
+  REQUIRE(playback.size() == 3);
+  REQUIRE(playback.next_time() == 0.5);
+
+  REQUIRE(playback.next(0.4) == nullptr);
+  const auto* key = playback.next(0.5);
+  REQUIRE(key != nullptr);
+  REQUIRE(key->type == input_recording::RecordType::KEY);
+  REQUIRE(key->code == 65);
+  REQUIRE(key->action == 1);
+
+  // everything that is due comes out at once
+  const auto* gamepad = playback.next(10.0);
+  REQUIRE(gamepad != nullptr);
+  REQUIRE(gamepad->type == input_recording::RecordType::GAMEPAD);
+  const auto event = input_recording::to_gamepad_event(*gamepad);
+  REQUIRE(event.time == 1.0);
+  REQUIRE(event.joystick == 3);
+  REQUIRE(event.type == GamepadEvent::Type::AXIS_MOVED);
+  REQUIRE(event.index == 4);
+  REQUIRE(event.value == 0.75f);
+
+  const auto* resize = playback.next(10.0);
+  REQUIRE(resize != nullptr);
+  REQUIRE(resize->type == input_recording::RecordType::RESIZE);
+  REQUIRE(resize->code == 800);
+  REQUIRE(resize->action == 600);
+
+  REQUIRE(playback.next(10.0) == nullptr);
+  REQUIRE(playback.finished());
+  REQUIRE_FALSE(playback.next_time().has_value());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("corrupt recordings are rejected", "[input_recording]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_input_recording_corrupt.bin";
+
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "not an input recording";
+  }
+  REQUIRE_THROWS_AS(InputPlayback{path}, std::runtime_error);
+
+  {
+    InputRecorder recorder{path};
+    recorder.record_key(0.0, 1, 1);
+  }
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  REQUIRE_THROWS_AS(InputPlayback{path}, std::runtime_error);
+
+  std::filesystem::remove(path);
+  REQUIRE_THROWS_AS(InputPlayback{path}, std::runtime_error);
+}
@@ -0,0 +1,50 @@
+#include "monitor_database.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <vector>
+
+namespace {
+  GLFWvidmode mode(int width, int height, int refresh_rate, int bits = 8)
+  {
+    return {width, height, bits, bits, bits, refresh_rate};
+  }
+}
+
+TEST_CASE("the best mode has the highest refresh rate at the resolution", "[monitor_database]")
+{
+  const std::vector<GLFWvidmode> modes{
+    mode(1920, 1080, 60),
+    mode(1920, 1080, 144, 6),
+    mode(2560, 1440, 165),
+    mode(1920, 1080, 144),
+    mode(1280, 720, 240),
+  };
+
+  const auto best = MonitorDatabase::best_mode(modes, 1920, 1080);
+  REQUIRE(best.has_value());
+  REQUIRE(best->refreshRate == 144);
+  // the deeper of two modes with the same refresh rate
+  REQUIRE(best->redBits == 8);
+
+  REQUIRE_FALSE(MonitorDatabase::best_mode(modes, 800, 600).has_value());
+  REQUIRE_FALSE(MonitorDatabase::best_mode({}, 1920, 1080).has_value());
+}
+
+TEST_CASE("points are mapped to the monitor covering them", "[monitor_database]")
+{
+  std::vector<MonitorInfo> monitors(2);
+  monitors[0].x = 0;
+  monitors[0].y = 0;
+  monitors[0].current_mode = mode(1920, 1080, 60);
+  monitors[1].x = 1920;
+  monitors[1].y = 0;
+  monitors[1].current_mode = mode(2560, 1440, 144);
+
+  REQUIRE(MonitorDatabase::monitor_at(monitors, 100, 100) == &monitors[0]);
+  REQUIRE(MonitorDatabase::monitor_at(monitors, 1919, 1079) == &monitors[0]);
+  REQUIRE(MonitorDatabase::monitor_at(monitors, 1920, 0) == &monitors[1]);
+  REQUIRE(MonitorDatabase::monitor_at(monitors, 3000, 1200) == &monitors[1]);
+  REQUIRE(MonitorDatabase::monitor_at(monitors, 100, 1200) == nullptr);
+  REQUIRE(MonitorDatabase::monitor_at(monitors, -1, 0) == nullptr);
+}
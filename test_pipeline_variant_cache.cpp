@@ -0,0 +1,67 @@
+#include "pipeline_variant_cache.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <unordered_set>
+
+namespace {
+  VkPipeline fake_pipeline(uintptr_t value)
+  {
+    return reinterpret_cast<VkPipeline>(value);
+  }
+}
+
+TEST_CASE("equal states hash equally", "[pipeline_variant_cache]")
+{
+  PipelineState a;
+  a.color_format = VK_FORMAT_B8G8R8A8_SRGB;
+  a.blend_enable = VK_TRUE;
+  PipelineState b = a;
+  REQUIRE(a == b);
+  REQUIRE(PipelineStateHash{}(a) == PipelineStateHash{}(b));
+
+  b.instanced = true;
+  REQUIRE(a != b);
+
+  // small enum differences should not collide
+  std::unordered_set<std::size_t> hashes;
+  for (auto polygon_mode : {VK_POLYGON_MODE_FILL, VK_POLYGON_MODE_LINE}) {
+    for (auto factor : {VK_BLEND_FACTOR_ZERO, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_SRC_ALPHA}) {
+      PipelineState state = a;
+      state.polygon_mode = polygon_mode;
+      state.src_color_blend_factor = factor;
+      hashes.insert(PipelineStateHash{}(state));
+    }
+  }
+  REQUIRE(hashes.size() == 6);
+}
+
+TEST_CASE("pipelines are only built on a miss", "[pipeline_variant_cache]")
+{
+  uintptr_t builds = 0;
+  PipelineVariantCache cache{VK_NULL_HANDLE, [&builds](const PipelineState&) { return fake_pipeline(++builds); }};
+
+  PipelineState opaque;
+  PipelineState blended;
+  blended.blend_enable = VK_TRUE;
+
+  const VkPipeline first = cache.get(opaque);
+  REQUIRE(cache.get(opaque) == first);
+  REQUIRE(cache.get(blended) != first);
+  REQUIRE(cache.get(blended) == cache.get(blended));
+  REQUIRE(builds == 2);
+  REQUIRE(cache.size() == 2);
+  REQUIRE(cache.misses() == 2);
+  REQUIRE(cache.hits() == 3);
+
+  const auto extracted = cache.extract_if([](const PipelineState& state) { return state.blend_enable; });
+  REQUIRE(extracted.size() == 1);
+  REQUIRE(cache.size() == 1);
+
+  // a new build after extracting
+  REQUIRE(cache.get(blended) == fake_pipeline(3));
+
+  // the cache destroys what it still owns, which fake handles must not reach
+  REQUIRE(cache.extract_if([](const PipelineState&) { return true; }).size() == 2);
+}
@@ -0,0 +1,100 @@
+#include "profiler.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  std::string trace()
+  {
+    std::ostringstream out;
+    profiler::write_chrome_trace(out);
+    return out.str();
+  }
+
+  bool contains(const std::string& text, const std::string& part)
+  {
+    return text.find(part) != std::string::npos;
+  }
+}
+
+TEST_CASE("zones of every thread end up in the trace", "[profiler]")
+{
+  profiler::set_enabled(true);
+  {
+    profiler::ScopedZone outer{"test_outer"};
+    profiler::ScopedZone inner{"test_inner"};
+  }
+
+  std::thread worker{[]() {
+    profiler::set_thread_name("test worker");
+    profiler::ScopedZone zone{"test_worker_zone"};
+  }};
+  worker.join();
+
+  const auto text = trace();
+  REQUIRE(text.rfind("{\"traceEvents\":[", 0) == 0);
+  REQUIRE(contains(text, "],\"displayTimeUnit\":\"ns\"}"));
+  REQUIRE(contains(text, R"({"name":"test_outer","ph":"X")"));
+  REQUIRE(contains(text, R"({"name":"test_inner","ph":"X")"));
+  REQUIRE(contains(text, R"({"name":"test_worker_zone","ph":"X")"));
+  REQUIRE(contains(text, R"("args":{"name":"test worker"})"));
+
+  // zones are appended when they end, so inner scopes come first
+  REQUIRE(text.find("test_inner") < text.find("test_outer"));
+}
+
+TEST_CASE("zone names are escaped", "[profiler]")
+{
+  profiler::set_enabled(true);
+  {
+    profiler::ScopedZone zone{"quoted \"zone\"\n"};
+  }
+
+  REQUIRE(contains(trace(), R"("quoted \"zone\"\u000a")"));
+}
+
+TEST_CASE("nothing is recorded while disabled", "[profiler]")
+{
+  profiler::set_enabled(false);
+  const profiler::ThreadBuffer* buffer = nullptr;
+  std::thread worker{[&buffer]() {
+    {
+      profiler::ScopedZone zone{"test_disabled_zone"};
+    }
+    buffer = &profiler::thread_buffer();
+  }};
+  worker.join();
+
+  REQUIRE(buffer->size() == 0);
+  REQUIRE(buffer->snapshot().empty());
+  REQUIRE_FALSE(contains(trace(), "test_disabled_zone"));
+}
+
+TEST_CASE("a full ring overwrites the oldest zones", "[profiler]")
+{
+  profiler::set_enabled(true);
+  const profiler::ThreadBuffer* buffer = nullptr;
+  std::thread worker{[&buffer]() {
+    for (int i = 0; i < 10; ++i)
+      profiler::ScopedZone zone{"test_old_zone"};
+    for (std::size_t i = 0; i < profiler::RING_SIZE; ++i)
+      profiler::ScopedZone zone{"test_new_zone"};
+    buffer = &profiler::thread_buffer();
+  }};
+  worker.join();
+
+  // buffers outlive their threads
+  REQUIRE(buffer->size() == profiler::RING_SIZE + 10);
+  REQUIRE(buffer->overwritten_zones() == 10);
+
+  const auto zones = buffer->snapshot();
+  REQUIRE(zones.size() == profiler::RING_SIZE);
+  REQUIRE(std::strcmp(zones.front().name, "test_new_zone") == 0);
+  REQUIRE(zones.front().end <= zones.back().begin);
+  REQUIRE_FALSE(contains(trace(), "test_old_zone"));
+}
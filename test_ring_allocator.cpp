@@ -0,0 +1,74 @@
+#include "ring_allocator.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+TEST_CASE("ring allocations are aligned and consecutive", "[ring_allocator]")
+{
+  RingAllocator ring{1024};
+
+  const auto a = ring.allocate(10, 1);
+  const auto b = ring.allocate(100, 256);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  REQUIRE(*a == 0);
+  REQUIRE(*b == 256);
+  REQUIRE(ring.used() == 356);
+
+  REQUIRE_THROWS_AS(ring.allocate(8, 3), std::invalid_argument);
+  REQUIRE_THROWS_AS(RingAllocator{0}, std::invalid_argument);
+}
+
+TEST_CASE("frames are released once their value is reached", "[ring_allocator]")
+{
+  RingAllocator ring{1000};
+
+  REQUIRE(ring.allocate(400, 1).has_value());
+  ring.end_frame(1);
+  REQUIRE(ring.allocate(400, 1).has_value());
+  ring.end_frame(2);
+  REQUIRE_FALSE(ring.allocate(400, 1).has_value());
+
+  // frame 2 is still in flight
+  ring.release(1);
+  REQUIRE(ring.used() == 400);
+
+  // the 200 bytes left at the end are skipped
+  const auto c = ring.allocate(300, 1);
+  REQUIRE(c.has_value());
+  REQUIRE(*c == 0);
+  REQUIRE(ring.used() == 900);
+  ring.end_frame(3);
+  REQUIRE_FALSE(ring.allocate(200, 1).has_value());
+
+  ring.release(2);
+  REQUIRE(ring.used() == 500);
+  const auto d = ring.allocate(400, 1);
+  REQUIRE(d.has_value());
+  REQUIRE(*d == 300);
+  ring.end_frame(4);
+
+  ring.release(4);
+  REQUIRE(ring.used() == 0);
+  REQUIRE(*ring.allocate(1000, 1) == 0);
+}
+
+TEST_CASE("allocations never overwrite frames in flight", "[ring_allocator]")
+{
+  RingAllocator ring{256};
+
+  for (std::uint64_t frame = 1; frame <= 100; ++frame) {
+    const auto offset = ring.allocate(48, 16);
+    REQUIRE(offset.has_value());
+    REQUIRE(*offset % 16 == 0);
+    REQUIRE(*offset + 48 <= ring.capacity());
+    ring.end_frame(frame);
+
+    // two frames in flight
+    if (frame >= 2)
+      ring.release(frame - 2);
+    REQUIRE(ring.used() <= ring.capacity());
+  }
+}
@@ -0,0 +1,46 @@
+#include "rolling_statistics.hpp"
+
+#include "catch2/catch_approx.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+TEST_CASE("empty statistics summarize to zero", "[rolling_statistics]")
+{
+  RollingStatistics statistics{4};
+
+  const auto summary = statistics.summary();
+  REQUIRE(summary.count == 0);
+  REQUIRE(summary.avg == 0.0);
+}
+
+TEST_CASE("statistics summarize all samples", "[rolling_statistics]")
+{
+  RollingStatistics statistics{100};
+  for (int sample = 1; sample <= 100; ++sample) {
+    statistics.add(sample);
+  }
+
+  const auto summary = statistics.summary();
+  REQUIRE(summary.count == 100);
+  REQUIRE(summary.min == 1.0);
+  REQUIRE(summary.max == 100.0);
+  REQUIRE(summary.avg == Catch::Approx(50.5));
+  REQUIRE(summary.p99 == 99.0);
+}
+
+TEST_CASE("statistics only keep the most recent samples", "[rolling_statistics]")
+{
+  RollingStatistics statistics{3};
+  statistics.add(100.0);
+  statistics.add(1.0);
+  statistics.add(2.0);
+  statistics.add(3.0);
+
+  REQUIRE(statistics.size() == 3);
+  const auto summary = statistics.summary();
+  REQUIRE(summary.min == 1.0);
+  REQUIRE(summary.max == 3.0);
+  REQUIRE(summary.p99 == 3.0);
+
+  statistics.clear();
+  REQUIRE(statistics.size() == 0);
+}
@@ -0,0 +1,49 @@
+#include "spsc_queue.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("items come out in order until the queue is empty", "[spsc_queue]")
+{
+  SpscQueue<int, 4> queue;
+  REQUIRE(queue.empty());
+  REQUIRE_FALSE(queue.try_pop().has_value());
+
+  for (int i = 0; i < 4; ++i)
+    REQUIRE(queue.try_push(i));
+  REQUIRE_FALSE(queue.try_push(4));
+
+  REQUIRE(queue.try_pop() == 0);
+  REQUIRE(queue.try_push(4));
+  for (int i = 1; i <= 4; ++i)
+    REQUIRE(queue.try_pop() == i);
+  REQUIRE(queue.empty());
+}
+
+TEST_CASE("items cross threads in order", "[spsc_queue]")
+{
+  constexpr std::uint64_t count = 1'000'000;
+  SpscQueue<std::uint64_t, 64> queue;
+
+  std::thread producer{[&queue]() {
+    for (std::uint64_t i = 0; i < count; ++i) {
+      while (!queue.try_push(i))
+        std::this_thread::yield();
+    }
+  }};
+
+  std::uint64_t expected = 0;
+  bool in_order = true;
+  while (expected < count) {
+    if (const auto value = queue.try_pop()) {
+      in_order = in_order && *value == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+
+  REQUIRE(in_order);
+  REQUIRE(queue.empty());
+}
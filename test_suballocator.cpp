@@ -0,0 +1,86 @@
+#include "suballocator.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("free list allocations are aligned and disjoint", "[suballocator]")
+{
+  FreeListSuballocator allocator{1024};
+
+  const auto a = allocator.allocate(10, 1);
+  const auto b = allocator.allocate(100, 64);
+  REQUIRE(a.has_value());
+  REQUIRE(b.has_value());
+  REQUIRE(*a == 0);
+  REQUIRE(*b % 64 == 0);
+  REQUIRE(*b >= *a + 10);
+
+  // the padding in front of b is still usable
+  const auto c = allocator.allocate(8, 8);
+  REQUIRE(c.has_value());
+  REQUIRE(*c < *b);
+}
+
+TEST_CASE("free list merges adjacent free regions", "[suballocator]")
+{
+  FreeListSuballocator allocator{300};
+
+  const auto a = allocator.allocate(100, 1);
+  const auto b = allocator.allocate(100, 1);
+  const auto c = allocator.allocate(100, 1);
+  REQUIRE(c.has_value());
+  REQUIRE_FALSE(allocator.allocate(1, 1).has_value());
+
+  allocator.free(*a);
+  allocator.free(*c);
+  auto statistics = allocator.statistics();
+  REQUIRE(statistics.free_region_count == 2);
+  REQUIRE(statistics.largest_free_region == 100);
+  REQUIRE(statistics.fragmentation() > 0.0);
+  REQUIRE_FALSE(allocator.allocate(200, 1).has_value());
+
+  allocator.free(*b);
+  statistics = allocator.statistics();
+  REQUIRE(statistics.free_region_count == 1);
+  REQUIRE(statistics.largest_free_region == 300);
+  REQUIRE(statistics.fragmentation() == 0.0);
+  REQUIRE(allocator.empty());
+}
+
+TEST_CASE("buddy allocations are rounded to powers of two", "[suballocator]")
+{
+  BuddySuballocator allocator{4096, 256};
+
+  const auto a = allocator.allocate(300, 4);
+  REQUIRE(a.has_value());
+  REQUIRE(*a % 512 == 0);
+  REQUIRE(allocator.statistics().used == 512);
+
+  const auto b = allocator.allocate(1, 1024);
+  REQUIRE(b.has_value());
+  REQUIRE(*b % 1024 == 0);
+}
+
+TEST_CASE("buddy allocator coalesces freed buddies", "[suballocator]")
+{
+  BuddySuballocator allocator{1024, 256};
+
+  std::vector<std::uint64_t> offsets;
+  for (int i = 0; i < 4; ++i) {
+    const auto offset = allocator.allocate(256, 1);
+    REQUIRE(offset.has_value());
+    offsets.push_back(*offset);
+  }
+  REQUIRE_FALSE(allocator.allocate(1, 1).has_value());
+
+  for (const auto offset : offsets) {
+    allocator.free(offset);
+  }
+
+  const auto statistics = allocator.statistics();
+  REQUIRE(statistics.free_region_count == 1);
+  REQUIRE(statistics.largest_free_region == 1024);
+  REQUIRE(allocator.allocate(1024, 1).has_value());
+}
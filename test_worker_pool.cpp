@@ -0,0 +1,46 @@
+#include "worker_pool.hpp"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("jobs run concurrently and return their results", "[worker_pool]")
+{
+  WorkerPool pool{4};
+  REQUIRE(pool.size() == 4);
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i)
+    results.push_back(pool.submit([i]() { return i * i; }));
+
+  for (int i = 0; i < 100; ++i)
+    REQUIRE(results[static_cast<std::size_t>(i)].get() == i * i);
+}
+
+TEST_CASE("exceptions are passed to the future", "[worker_pool]")
+{
+  WorkerPool pool{1};
+  auto result = pool.submit([]() -> int { throw std::runtime_error("failed"); });
+  REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+
+  // the worker survives the exception
+  REQUIRE(pool.submit([]() { return 1; }).get() == 1);
+}
+
+TEST_CASE("queued jobs run before the pool is destroyed", "[worker_pool]")
+{
+  std::atomic<int> count{0};
+  {
+    WorkerPool pool{2};
+    for (int i = 0; i < 50; ++i)
+      pool.submit([&count]() { ++count; });
+  }
+  REQUIRE(count == 50);
+}
+
+TEST_CASE("a pool without threads is rejected", "[worker_pool]")
+{
+  REQUIRE_THROWS_AS(WorkerPool{0}, std::invalid_argument);
+}
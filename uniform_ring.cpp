@@ -0,0 +1,146 @@
+#include "uniform_ring.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+UniformRing::UniformRing(VkDevice device,
+                         GpuAllocator& allocator,
+                         VkDeviceSize capacity,
+                         VkDeviceSize min_uniform_buffer_offset_alignment,
+                         VkDeviceSize binding_range,
+                         VkShaderStageFlags stages) :
+    device{device},
+    allocator{allocator},
+    alignment{min_uniform_buffer_offset_alignment},
+    binding_range{binding_range},
+    ring{capacity}
+{
+  if (capacity > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("dynamic offsets into the uniform ring have to fit 32 bits!");
+  }
+
+  try {
+    // the range bound at the last offset may reach past the ring
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = capacity + binding_range;
+    buffer_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create uniform ring buffer!");
+    }
+    allocation = allocator.allocate_buffer_memory(buffer,
+                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                  VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = stages;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &set_layout) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create uniform ring descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_size.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create uniform ring descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo set_info{};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = descriptor_pool;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &set_layout;
+    if (vkAllocateDescriptorSets(device, &set_info, &set) != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate uniform ring descriptor set!");
+    }
+
+    VkDescriptorBufferInfo buffer_range{buffer, 0, binding_range};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &buffer_range;
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+UniformRing::~UniformRing()
+{
+  destroy();
+}
+
+void UniformRing::destroy()
+{
+  // destroying the pool frees its descriptor set
+  vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+  vkDestroyDescriptorSetLayout(device, set_layout, nullptr);
+  vkDestroyBuffer(device, buffer, nullptr);
+  allocator.free(allocation);
+}
+
+UniformRing::Range UniformRing::allocate(VkDeviceSize size)
+{
+  if (size > binding_range) {
+    throw std::invalid_argument("uniform data is larger than the bound range!");
+  }
+
+  const auto offset = ring.allocate(size, alignment);
+  if (!offset) {
+    throw std::runtime_error("uniform ring is full!");
+  }
+
+  return {static_cast<uint32_t>(*offset), static_cast<unsigned char*>(allocation.mapped) + *offset};
+}
+
+uint32_t UniformRing::write(const void* data, VkDeviceSize size)
+{
+  const Range range = allocate(size);
+  std::memcpy(range.data, data, static_cast<std::size_t>(size));
+  return range.offset;
+}
+
+void UniformRing::end_frame(uint64_t value)
+{
+  ring.end_frame(value);
+}
+
+void UniformRing::release(uint64_t completed_value)
+{
+  ring.release(completed_value);
+}
+
+void UniformRing::reset()
+{
+  ring.reset();
+}
+
+VkDescriptorSetLayout UniformRing::descriptor_set_layout() const
+{
+  return set_layout;
+}
+
+VkDescriptorSet UniformRing::descriptor_set() const
+{
+  return set;
+}
@@ -0,0 +1,67 @@
+#ifndef UNIFORM_RING_HPP
+#define UNIFORM_RING_HPP
+
+#include "gpu_allocator.hpp"
+#include "ring_allocator.hpp"
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstdint>
+
+//! persistently mapped uniform buffer that hands out a range per use
+//!
+//! The buffer is bound once through a dynamic uniform buffer
+//! descriptor of \p binding_range bytes, every draw selects its range
+//! with the dynamic offset. Ranges written during a frame are tagged
+//! with the timeline value of that frame by end_frame() and reused
+//! once release() sees the value completed. The memory is host
+//! coherent, writes need no flush.
+class UniformRing
+{
+public:
+  struct Range
+  {
+    //! the dynamic offset to bind
+    uint32_t offset;
+    void* data;
+  };
+
+  UniformRing(VkDevice device,
+              GpuAllocator& allocator,
+              VkDeviceSize capacity,
+              VkDeviceSize min_uniform_buffer_offset_alignment,
+              VkDeviceSize binding_range,
+              VkShaderStageFlags stages);
+  UniformRing(const UniformRing&) = delete;
+  UniformRing& operator=(const UniformRing&) = delete;
+  ~UniformRing();
+
+  //! throws if all of the ring is still in flight
+  Range allocate(VkDeviceSize size);
+  //! copies \p data into a new range and returns its dynamic offset
+  uint32_t write(const void* data, VkDeviceSize size);
+  void end_frame(uint64_t value);
+  void release(uint64_t completed_value);
+  //! drops every range, none of them may be in use by the GPU
+  void reset();
+
+  VkDescriptorSetLayout descriptor_set_layout() const;
+  VkDescriptorSet descriptor_set() const;
+
+private:
+  void destroy();
+
+  VkDevice device;
+  GpuAllocator& allocator;
+  VkDeviceSize alignment;
+  VkDeviceSize binding_range;
+  RingAllocator ring;
+
+  VkBuffer buffer = VK_NULL_HANDLE;
+  GpuAllocation allocation;
+  VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+  VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+  VkDescriptorSet set = VK_NULL_HANDLE;
+};
+
+#endif // UNIFORM_RING_HPP
@@ -5,6 +5,16 @@ layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
+layout(set = 0, binding = 0) uniform FrameUniforms {
+  // scale in xy, offset in zw
+  vec4 transform;
+  float time;
+} frame;
+
+layout(push_constant) uniform DrawConstants {
+  vec4 tint;
+} draw;
+
 vec3 colors[3] = vec3[](
   vec3(1.0, 0.0, 0.0),
   vec3(0.0, 1.0, 0.0),
@@ -18,6 +28,6 @@ vec2 positions[3] = vec2[](
 );
 
 void main() {
-  gl_Position = vec4(inPosition, 0.0, 1.0);
-  fragColor = inColor;
+  gl_Position = vec4(inPosition * frame.transform.xy + frame.transform.zw, 0.0, 1.0);
+  fragColor = inColor * draw.tint.rgb;
 }
@@ -0,0 +1,26 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 2) in vec2 instanceOffset;
+layout(location = 3) in float instanceScale;
+layout(location = 4) in vec3 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+layout(set = 0, binding = 0) uniform FrameUniforms {
+  // scale in xy, offset in zw
+  vec4 transform;
+  float time;
+} frame;
+
+layout(push_constant) uniform DrawConstants {
+  vec4 tint;
+} draw;
+
+void main() {
+  vec2 position = inPosition * instanceScale + instanceOffset;
+  gl_Position = vec4(position * frame.transform.xy + frame.transform.zw, 0.0, 1.0);
+  fragColor = inColor * instanceColor * draw.tint.rgb;
+}
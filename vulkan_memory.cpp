@@ -0,0 +1,19 @@
+#include "vulkan_memory.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties& mem_properties,
+                          uint32_t type_filter,
+                          VkMemoryPropertyFlags properties)
+{
+  assert(mem_properties.memoryTypeCount <= sizeof(type_filter) * 8);
+  for (uint32_t index = 0; index < mem_properties.memoryTypeCount; ++index) {
+    if ((type_filter & (1U << index)) &&
+        (mem_properties.memoryTypes[index].propertyFlags & properties) == properties) {
+      return index;
+    }
+  }
+
+  throw std::runtime_error("no suitable memory found");
+}
@@ -0,0 +1,14 @@
+#ifndef VULKAN_MEMORY_HPP
+#define VULKAN_MEMORY_HPP
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstdint>
+
+//! returns the index of the first memory type which is allowed by
+//! \p type_filter and has all \p properties, throws otherwise
+uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties& mem_properties,
+                          uint32_t type_filter,
+                          VkMemoryPropertyFlags properties);
+
+#endif // VULKAN_MEMORY_HPP
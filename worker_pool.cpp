@@ -0,0 +1,75 @@
+#include "worker_pool.hpp"
+
+#include "profiler.hpp"
+
+#include <stdexcept>
+
+WorkerPool::WorkerPool(uint32_t thread_count)
+{
+  if (thread_count == 0) {
+    throw std::invalid_argument("a worker pool needs at least one thread");
+  }
+
+  threads.reserve(thread_count);
+  try {
+    for (uint32_t thread = 0; thread < thread_count; ++thread)
+      threads.emplace_back(&WorkerPool::run_worker, this);
+  } catch (...) {
+    // the destructor does not run, joinable threads left in the vector
+    // would terminate the process
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      stopping = true;
+    }
+    job_ready.notify_all();
+    for (auto& thread : threads)
+      thread.join();
+    throw;
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  job_ready.notify_all();
+  for (auto& thread : threads)
+    thread.join();
+}
+
+uint32_t WorkerPool::size() const
+{
+  return static_cast<uint32_t>(threads.size());
+}
+
+void WorkerPool::push(std::function<void()> job)
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    jobs.push_back(std::move(job));
+  }
+  job_ready.notify_one();
+}
+
+void WorkerPool::run_worker()
+{
+  PROFILE_THREAD_NAME("worker pool");
+  for (;;) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      job_ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty())
+        return;
+
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+
+    // packaged_task stores exceptions in its future
+    PROFILE_ZONE("worker pool job");
+    job();
+  }
+}
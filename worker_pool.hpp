@@ -0,0 +1,52 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//! runs jobs on a fixed set of threads
+//!
+//! Meant for coarse jobs such as building pipelines, every job takes
+//! the lock once. Jobs which are still queued on destruction are run
+//! before the threads are joined, so no returned future is abandoned.
+class WorkerPool
+{
+public:
+  explicit WorkerPool(uint32_t thread_count);
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool();
+
+  uint32_t size() const;
+
+  //! an exception thrown by \p function is rethrown by get() of the
+  //! returned future
+  template <typename Function>
+  std::future<std::invoke_result_t<Function>> submit(Function function)
+  {
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    auto result = task->get_future();
+    push([task]() { (*task)(); });
+    return result;
+  }
+
+private:
+  void push(std::function<void()> job);
+  void run_worker();
+
+  std::mutex mutex;
+  std::condition_variable job_ready;
+  std::deque<std::function<void()>> jobs;
+  bool stopping = false;
+  std::vector<std::thread> threads;
+};
+
+#endif // WORKER_POOL_HPP